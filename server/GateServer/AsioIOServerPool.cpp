@@ -36,6 +36,14 @@ boost::asio::io_context& AsioIOServerPool::GetIOService() {
 	return service;
 }
 
+boost::asio::io_context& AsioIOServerPool::GetIOService(std::size_t index) {
+	return _ioServices[index % _ioServices.size()];
+}
+
+std::size_t AsioIOServerPool::Size() const {
+	return _ioServices.size();
+}
+
 void AsioIOServerPool::stop() {
 	_works.clear(); //  work 
 
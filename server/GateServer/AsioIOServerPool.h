@@ -21,6 +21,9 @@ public:
 	
 	// ʹ round-robin ķʽһ io_service
 	boost::asio::io_context& GetIOService();
+	// ±귵 io_serviceڸÿ̰߳󶨸Ե acceptor
+	boost::asio::io_context& GetIOService(std::size_t index);
+	std::size_t Size() const;
 
 	void stop();
 private:
@@ -1,14 +1,37 @@
 #include"CServer.h"
 
-CServer::CServer(boost::asio::io_context& ioc, unsigned short& port)
-	: _acceptor(ioc, tcp::endpoint(tcp::v4(), port)), _ioc(ioc), _socket(ioc)
+#ifdef SO_REUSEPORT
+using reuse_port = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+CServer::CServer(boost::asio::io_context& ioc, unsigned short& port, bool reusePort)
+	: _reusePort(reusePort && ReusePortSupported()), _acceptor(ioc), _ioc(ioc), _socket(ioc)
 {
+	tcp::endpoint endpoint(tcp::v4(), port);
+	_acceptor.open(endpoint.protocol());
+	_acceptor.set_option(tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+	if (_reusePort) {
+		_acceptor.set_option(reuse_port(true));
+	}
+#endif
+	_acceptor.bind(endpoint);
+	_acceptor.listen(net::socket_base::max_listen_connections);
+}
+
+bool CServer::ReusePortSupported() {
+#ifdef SO_REUSEPORT
+	return true;
+#else
+	return false;
+#endif
 }
 
 void CServer::Start() {
 	auto self = shared_from_this();
 	//contextpoolлȡһio_context
-	auto& io_context = AsioIOServerPool::GetInstance()->GetIOService();
+	//SO_REUSEPORTģʽÿ߳Լacceptorڵǰio_contextϴ
+	auto& io_context = _reusePort ? _ioc : AsioIOServerPool::GetInstance()->GetIOService();
 	std::shared_ptr<HttpConnection> new_con = std::make_shared<HttpConnection>(tcp::socket(io_context));
 	_acceptor.async_accept(new_con->GetSocket(), [self,new_con](beast::error_code ec) {
 		try {
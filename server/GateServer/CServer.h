@@ -6,9 +6,14 @@
 class CServer :public std::enable_shared_from_this<CServer>
 {
 public:
-    CServer(boost::asio::io_context& ioc, unsigned short& port);
+    //reusePortΪtrueʱSO_REUSEPORTCServerԼͬһ˿ڣ
+    //ֱacceptorڵio_contextϴٿ̡߳
+    CServer(boost::asio::io_context& ioc, unsigned short& port, bool reusePort = false);
     void Start();
+    //ǰƽ̨Ƿ֧SO_REUSEPORT
+    static bool ReusePortSupported();
 private:
+    bool _reusePort;
     tcp::acceptor  _acceptor;
     net::io_context& _ioc;
     boost::asio::ip::tcp::socket   _socket;
@@ -1,6 +1,36 @@
 #include "ConfigMgr.h"
 #include"const.h"
 ConfigMgr::ConfigMgr() {
+    _config_map = Load();
+
+    // еsectionkey-value  
+    for (const auto& section_entry : _config_map) {
+        const std::string& section_name = section_entry.first;
+        SectionInfo section_config = section_entry.second;
+        std::cout << "[" << section_name << "]" << std::endl;
+        for (const auto& key_value_pair : section_config._section_datas) {
+            std::cout << key_value_pair.first << "=" << key_value_pair.second << std::endl;
+        }
+    }
+
+}
+
+bool ConfigMgr::Reload() {
+    std::map<std::string, SectionInfo> config_map;
+    try {
+        config_map = Load();
+    }
+    catch (std::exception& e) {
+        std::cout << "reload config failed: " << e.what() << std::endl;
+        return false;
+    }
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    _config_map.swap(config_map);
+    return true;
+}
+
+std::map<std::string, SectionInfo> ConfigMgr::Load() {
+    std::map<std::string, SectionInfo> config_map;
     // ȡǰĿ¼  
     boost::filesystem::path current_path = boost::filesystem::current_path();
     // config.iniļ·  
@@ -27,17 +57,7 @@ ConfigMgr::ConfigMgr() {
         SectionInfo sectionInfo;
         sectionInfo._section_datas = section_config;
         // sectionkey-valueԱ浽config_map  
-        _config_map[section_name] = sectionInfo;
+        config_map[section_name] = sectionInfo;
     }
-
-    // еsectionkey-value  
-    for (const auto& section_entry : _config_map) {
-        const std::string& section_name = section_entry.first;
-        SectionInfo section_config = section_entry.second;
-        std::cout << "[" << section_name << "]" << std::endl;
-        for (const auto& key_value_pair : section_config._section_datas) {
-            std::cout << key_value_pair.first << "=" << key_value_pair.second << std::endl;
-        }
-    }
-
+    return config_map;
 }
\ No newline at end of file
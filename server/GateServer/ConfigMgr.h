@@ -1,5 +1,6 @@
 #pragma once
 #include"const.h"
+#include <shared_mutex>
 struct SectionInfo {
     SectionInfo() {}
     ~SectionInfo() {
@@ -16,6 +17,7 @@ struct SectionInfo {
         }
 
         this->_section_datas = src._section_datas;
+        return *this;
     }
 
     std::map<std::string, std::string> _section_datas;
@@ -38,12 +40,17 @@ public:
         _config_map.clear();
     }
     SectionInfo operator[](const std::string& section) {
-        if (_config_map.find(section) == _config_map.end()) {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        auto it = _config_map.find(section);
+        if (it == _config_map.end()) {
             return SectionInfo();
         }
-        return _config_map[section];
+        return it->second;
     }
 
+    //ʱ¶ȡconfig.iniȡʧʱԭ
+    bool Reload();
+
 
     ConfigMgr& operator=(const ConfigMgr& src) {
         if (&src == this) {
@@ -51,14 +58,18 @@ public:
         }
 
         this->_config_map = src._config_map;
+        return *this;
     };
 
 private:
     ConfigMgr();
+    //config.iniʧʱ׳쳣
+    static std::map<std::string, SectionInfo> Load();
     
     ConfigMgr(const ConfigMgr& src) {
         this->_config_map = src._config_map;
     }
     // 洢sectionkey-valueԵmap  
     std::map<std::string, SectionInfo> _config_map;
+    std::shared_mutex _mutex;
 };
\ No newline at end of file
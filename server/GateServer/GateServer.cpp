@@ -1,5 +1,6 @@
 ﻿#include"const.h"
 #include"CServer.h"
+#include"db/DBManager.h"
 
 //void TestRedis() {
 //    //连接redis 需要启动才可以进行连接
@@ -107,8 +108,21 @@ int main()
             }
             ioc.stop();
         });
-        std::make_shared<CServer>(ioc, gate_port)->Start();
+        //ReusePort开启时每个io_context线程各自监听同一端口，accept/读/处理/写都留在同一线程；
+        //否则沿用单acceptor，把连接分发给AsioIOServerPool。
+        bool reuse_port = ConfigMgr::Inst()[GATE_CONFIG_SECTION][GATE_REUSE_PORT_KEY] == "true";
+        if (reuse_port && CServer::ReusePortSupported()) {
+            auto pool = AsioIOServerPool::GetInstance();
+            for (std::size_t i = 0; i < pool->Size(); ++i) {
+                std::make_shared<CServer>(pool->GetIOService(i), gate_port, true)->Start();
+            }
+        }
+        else {
+            std::make_shared<CServer>(ioc, gate_port)->Start();
+        }
         ioc.run();
+        //正常退出时关闭连接池，关闭前会先写完延迟写入队列
+        gDBManager.shutdownDBConnectionPool();
     }
     catch (std::exception const& e)
     {
@@ -1,26 +1,98 @@
 ﻿#include "HttpConnection.h"
 #include"LogicSystem.h"
+namespace {
+	//长连接配置，只在首次使用时从config.ini读取一次。
+	struct KeepAliveConfig {
+		bool enabled = true;
+		std::chrono::seconds idleTimeout{ GATE_DEFAULT_IDLE_TIMEOUT };
+		std::chrono::seconds requestTimeout{ GATE_DEFAULT_REQUEST_TIMEOUT };
+		std::size_t maxRequests = GATE_DEFAULT_MAX_KEEP_ALIVE_REQUESTS;
+	};
+
+	const KeepAliveConfig& GetKeepAliveConfig() {
+		static const KeepAliveConfig config = [] {
+			KeepAliveConfig cfg;
+			auto section = ConfigMgr::Inst()[GATE_CONFIG_SECTION];
+			std::string enabled = section[GATE_KEEP_ALIVE_KEY];
+			if (!enabled.empty()) {
+				cfg.enabled = (enabled == "true" || enabled == "1");
+			}
+			std::string timeout = section[GATE_IDLE_TIMEOUT_KEY];
+			if (!timeout.empty() && atoi(timeout.c_str()) > 0) {
+				cfg.idleTimeout = std::chrono::seconds(atoi(timeout.c_str()));
+			}
+			std::string requestTimeout = section[GATE_REQUEST_TIMEOUT_KEY];
+			if (!requestTimeout.empty() && atoi(requestTimeout.c_str()) > 0) {
+				cfg.requestTimeout = std::chrono::seconds(atoi(requestTimeout.c_str()));
+			}
+			std::string maxRequests = section[GATE_MAX_KEEP_ALIVE_REQUESTS_KEY];
+			if (!maxRequests.empty() && atoi(maxRequests.c_str()) > 0) {
+				cfg.maxRequests = atoi(maxRequests.c_str());
+			}
+			return cfg;
+		}();
+		return config;
+	}
+}
+
+std::atomic<std::uint64_t> HttpConnection::_body_requests{ 0 };
+std::atomic<std::uint64_t> HttpConnection::_body_allocations{ 0 };
+
+std::atomic<std::uint64_t>& HeaderAllocations() {
+	static std::atomic<std::uint64_t> count{ 0 };
+	return count;
+}
+
 HttpConnection::HttpConnection(tcp::socket socket) :
 	_socket(std::move(socket)){
 }	
 
 void HttpConnection::Start() {
+	CheckDeadline();
+	ReadRequest();
+}
+
+void HttpConnection::ReadRequest() {
 	auto self = shared_from_this();
+	//每读取一个新请求都重新计算空闲超时，超时后由CheckDeadline关闭连接。
+	deadline_.expires_after(GetKeepAliveConfig().idleTimeout);
+	_request_capacity = _request.body().capacity();
+	_response_capacity = _response.body().capacity();
+	//流水线请求中多读到的数据会留在_buffer里，下一次async_read直接从中解析，
+	//因此同一连接上的请求总是按顺序处理、按顺序应答。
 	//bytes_transeferred是async_read 函数提供的 ​​实际读取字节数
 	http::async_read(_socket, _buffer, _request, [self](beast::error_code ec,
 		std::size_t bytes_transferred) {
 		try {
+			if (ec == http::error::end_of_stream)
+			{
+				//客户端主动关闭了长连接
+				self->CloseConnection();
+				return;
+			}
 			if (ec)
 			{	
-				std::cout << "error is" << ec.what() << std::endl;
+				if (ec != net::error::operation_aborted) {
+					std::cout << "error is" << ec.what() << std::endl;
+				}
+				self->CloseConnection();
 				return;
 			}
 			boost::ignore_unused(bytes_transferred);
+			//请求已读完，空闲计时不再适用：按请求时限处理，handler应在截止时间前完成。
+			//定时器只作兜底，handler超过截止时间一个空闲超时仍未完成时才关闭连接
+			const auto& cfg = GetKeepAliveConfig();
+			self->_request_deadline = std::chrono::steady_clock::now() + cfg.requestTimeout;
+			self->deadline_.expires_at(self->_request_deadline + cfg.idleTimeout);
+			++_body_requests;
+			if (self->_request.body().capacity() > self->_request_capacity) {
+				++_body_allocations;
+			}
 			self->HandleReq();
-			self->CheckDeadline();
 		}
 		catch (std::exception& exp) {
 			std::cout << "exception" << exp.what() << std::endl;
+			self->CloseConnection();
 		}
 	});
 }
@@ -29,47 +101,65 @@ tcp::socket& HttpConnection::GetSocket() {
 };
 void HttpConnection::HandleReq() {
 	//设置版本。
-	_request.version(_request.version());
-	//设置短连接。
-	_request.keep_alive(false);
+	_response.version(_request.version());
+	//客户端要求长连接且服务端开启长连接时保持连接，否则回复后关闭。
+	++_handled_requests;
+	const auto& keepAliveCfg = GetKeepAliveConfig();
+	_response.keep_alive(keepAliveCfg.enabled && _request.keep_alive() &&
+		_handled_requests < keepAliveCfg.maxRequests);
 	
+	//解析路径和查询参数，GET和POST共用。
+	PreParseGetParam();
+
 	//处理get请求。
 	if (_request.method() == http::verb::get)
 	{
 		//target()返回的是http请求的资源路径地址。
 		//shared_from_this()是返回当前对象的shared_ptr.
-		PreParseGetParam();
+		//路由存在时由LogicSystem在handler完成后调用CompleteReq写回应答。
 		bool success = LogicSystem::GetInstance()->HandleGet(_get_url, shared_from_this());
 		if (!success)
 		{	
 			_response.result(http::status::not_found);
 			_response.set(http::field::content_type, "text/plain");
-			beast::ostream(_response.body()) << "url not found\r\n";
+			_response.body().append("url not found\r\n");
 			WriteResponse();
-			return;
 		}
-
-		_response.result(http::status::ok);
-		_response.set(http::field::server, "GateServer");
-		WriteResponse();
 		return;
 	}
 
 	if (_request.method() == http::verb::post) {
-		bool success = LogicSystem::GetInstance()->HandlePost(_request.target(), shared_from_this());
+		bool success = LogicSystem::GetInstance()->HandlePost(_get_url, shared_from_this());
 		if (!success) {
 			_response.result(http::status::not_found);
 			_response.set(http::field::content_type, "text/plain");
-			beast::ostream(_response.body()) << "url not found\r\n";
+			_response.body().append("url not found\r\n");
 			WriteResponse();
-			return;
 		}
+		return;
+	}
 
-		_response.result(http::status::ok);
-		_response.set(http::field::server, "GateServer");
+	//其他请求方法不支持，也必须应答，否则长连接上后续的请求会被阻塞。
+	_response.result(http::status::bad_request);
+	_response.set(http::field::content_type, "text/plain");
+	_response.body().append("invalid request method\r\n");
+	WriteResponse();
+}
+
+void HttpConnection::CompleteReq(bool success) {
+	if (!success) {
+		//handler异常退出，丢弃写了一半的应答体
+		_response.body().clear();
+		_response.result(http::status::internal_server_error);
+		_response.set(http::field::content_type, "text/plain");
+		_response.body().append("internal server error\r\n");
 		WriteResponse();
 		return;
 	}
+
+	_response.result(http::status::ok);
+	_response.set(http::field::server, "GateServer");
+	WriteResponse();
 }
 
 unsigned char ToHex(unsigned char x)
@@ -116,7 +206,7 @@ std::string UrlEncode(const std::string& str)
 }
 
 
-std::string UrlDecode(const std::string& str)
+std::string UrlDecode(std::string_view str)
 {
 	std::string strTemp = "";
 	size_t length = str.length();
@@ -139,56 +229,107 @@ std::string UrlDecode(const std::string& str)
 
 
 void HttpConnection::PreParseGetParam() {
-	// 提取 URI  
-	auto uri = _request.target();
+	// 提取 URI，只记录各段在target中的位置，不拷贝
+	auto target = _request.target();
+	std::string_view uri(target.data(), target.size());
 	// 查找查询字符串的开始位置（即 '?' 的位置）  
 	auto query_pos = uri.find('?');
-	if (query_pos == std::string::npos) {
+	if (query_pos == std::string_view::npos) {
 		_get_url = uri;
 		return;
 	}
 
 	_get_url = uri.substr(0, query_pos);
-	std::string query_string = uri.substr(query_pos + 1);
-	std::string key;
-	std::string value;
-	size_t pos = 0;
-	while ((pos = query_string.find('&')) != std::string::npos) {
+	std::string_view query_string = uri.substr(query_pos + 1);
+	while (!query_string.empty()) {
+		auto pos = query_string.find('&');
 		auto pair = query_string.substr(0, pos);
 		size_t eq_pos = pair.find('=');
-		if (eq_pos != std::string::npos) {
-			key = UrlDecode(pair.substr(0, eq_pos)); // 假设有 url_decode 函数来处理URL解码  
-			value = UrlDecode(pair.substr(eq_pos + 1));
-			_get_params[key] = value;
+		if (eq_pos != std::string_view::npos) {
+			_get_params.emplace_back(pair.substr(0, eq_pos), pair.substr(eq_pos + 1));
 		}
-		query_string.erase(0, pos + 1);
+		if (pos == std::string_view::npos) {
+			break;
+		}
+		query_string.remove_prefix(pos + 1);
 	}
-	// 处理最后一个参数对（如果没有 & 分隔符）  
-	if (!query_string.empty()) {
-		size_t eq_pos = query_string.find('=');
-		if (eq_pos != std::string::npos) {
-			key = UrlDecode(query_string.substr(0, eq_pos));
-			value = UrlDecode(query_string.substr(eq_pos + 1));
-			_get_params[key] = value;
+}
+
+std::string HttpConnection::GetParam(std::string_view key) const {
+	for (auto& param : _path_params) {
+		if (param.first == key) {
+			return UrlDecode(param.second);
 		}
 	}
+	for (auto& param : _get_params) {
+		if (UrlDecode(param.first) == key) {
+			return UrlDecode(param.second);
+		}
+	}
+	return "";
 }
 
 void HttpConnection::WriteResponse() {
 	auto self = shared_from_this();
 	_response.content_length(_response.body().size());
+	if (_response.body().capacity() > _response_capacity) {
+		++_body_allocations;
+	}
+	//客户端迟迟不读应答时按空闲超时关闭
+	deadline_.expires_after(GetKeepAliveConfig().idleTimeout);
 	http::async_write(_socket, _response, [self](beast::error_code er,std::size_t outsize) {
-		self->_socket.shutdown(tcp::socket::shutdown_send,er);
-		self->deadline_.cancel();
+		if (er || !self->_response.keep_alive()) {
+			self->CloseConnection();
+			return;
+		}
+		//长连接：复用当前连接继续读取下一个请求。
+		self->ResetForNextRequest();
+		self->ReadRequest();
 	});
 }
 
+void HttpConnection::ResetForNextRequest() {
+	//只清空内容，保留两个body已经分配的容量给下一个请求使用
+	std::string requestBody = std::move(_request.body());
+	std::string responseBody = std::move(_response.body());
+	requestBody.clear();
+	responseBody.clear();
+	_request = http::request<http::string_body, Fields>();
+	_response = http::response<http::string_body, Fields>();
+	_request.body() = std::move(requestBody);
+	_response.body() = std::move(responseBody);
+	_get_params.clear();
+	_path_params.clear();
+	_get_url = {};
+}
+
+HttpConnection::AllocStats HttpConnection::GetAllocStats() {
+	return AllocStats{ _body_requests.load(), _body_allocations.load(), HeaderAllocations().load() };
+}
+
+void HttpConnection::CloseConnection() {
+	if (_closed) {
+		return;
+	}
+	_closed = true;
+	beast::error_code ec;
+	_socket.shutdown(tcp::socket::shutdown_send, ec);
+	deadline_.cancel();
+}
+
 void HttpConnection::CheckDeadline() {
 	auto self = shared_from_this();
 	deadline_.async_wait([self](beast::error_code er) {
-		if (!er)
+		if (self->_closed) {
+			return;
+		}
+		//定时器到期且期间没有被重新计时，说明连接空闲超时。
+		if (self->deadline_.expiry() <= std::chrono::steady_clock::now())
 		{
 			self->_socket.close(er);
+			return;
 		}
+		//计时被ReadRequest刷新，继续等待新的到期时间。
+		self->CheckDeadline();
 	});
 }
@@ -1,6 +1,35 @@
 #pragma once
 #include"const.h"
 #include"LogicSystem.h"
+
+//ͷӦͷۼƵڴ
+std::atomic<std::uint64_t>& HeaderAllocations();
+
+//ͷ/ӦͷֶõķΪstd::allocatorֻͬͳƷ
+//beastͷÿֶε䣬ͷӦͷõ
+template <typename T>
+class HeaderAllocator
+{
+public:
+	using value_type = T;
+	HeaderAllocator() = default;
+	template <typename U>
+	HeaderAllocator(const HeaderAllocator<U>&) noexcept {}
+
+	T* allocate(std::size_t n) {
+		HeaderAllocations().fetch_add(1, std::memory_order_relaxed);
+		return std::allocator<T>().allocate(n);
+	}
+	void deallocate(T* p, std::size_t n) noexcept {
+		std::allocator<T>().deallocate(p, n);
+	}
+
+	template <typename U>
+	bool operator==(const HeaderAllocator<U>&) const noexcept { return true; }
+	template <typename U>
+	bool operator!=(const HeaderAllocator<U>&) const noexcept { return false; }
+};
+
 class HttpConnection : public std::enable_shared_from_this<HttpConnection>
 {
 	friend class LogicSystem;
@@ -9,27 +38,68 @@ public:
 	HttpConnection(tcp::socket socket);
 	void Start();
 	Socket& GetSocket();
+	//ȡ·ѯ(ѽ)ʱؿմ
+	std::string GetParam(std::string_view key) const;
+	//Ľֹʱ䣺ʱRequestTimeoutã֮ͻ˲ٵȴӦ
+	//εòӦõȵʱ֮
+	std::chrono::steady_clock::time_point GetRequestDeadline() const { return _request_deadline; }
+
+	//еڴͳơ̬bodyAllocationsӦ
+	//ͷֶÿҪ·䣬headerAllocations/requestsÿͷ
+	struct AllocStats {
+		std::uint64_t requests;
+		std::uint64_t bodyAllocations;
+		std::uint64_t headerAllocations;
+	};
+	static AllocStats GetAllocStats();
 private:
+	void ReadRequest();
 	void CheckDeadline();
 	void WriteResponse();
 	void HandleReq();
+	//·handler(ͬЭ)ִϺдӦ
+	void CompleteReq(bool success);
 	void PreParseGetParam();
+	//һϺ״̬׼ͬһ϶ȡһ
+	void ResetForNextRequest();
+	void CloseConnection();
 	
 	Socket _socket;
 
-	std::unordered_map<std::string, std::string> _get_params;
+	//ѯ·ֱ_request.target()ֵURLʽUrlDecode
+	UrlParams _get_params;
+	UrlParams _path_params;
 	beast::flat_buffer _buffer{ 8192 };
-	//http::dynamic_body boost.beastṩһֶ̬͡
-	//
-	http::request<http::dynamic_body> _request;
+	//Ӧ嶼std::stringJSONֱյֽϽӦֱдbody
+	//ߵ֮䱣ã̬²ٷڴ档
+	//ͷֶHeaderAllocatorͳ
+	using Fields = http::basic_fields<HeaderAllocator<char>>;
+	http::request<http::string_body, Fields> _request;
 
-	http::response<http::dynamic_body> _response;
+	http::response<http::string_body, Fields> _response;
+
+	//ʼʱbodyͳǷ˷
+	std::size_t _request_capacity = 0;
+	std::size_t _response_capacity = 0;
+	static std::atomic<std::uint64_t> _body_requests;
+	static std::atomic<std::uint64_t> _body_allocations;
 	
+	//гʱʱÿοʼȡͿʼдӦʱ¼ʱ
+	//handlerִڼ䲻мʱֻԶֹʱ󶵵׹رӡ
 	net::steady_timer deadline_{
 		_socket.get_executor(),
 		std::chrono::seconds(60)
 	};
+	//ǰĴֹʱ䣬ʱRequestTimeout
+	std::chrono::steady_clock::time_point _request_deadline{};
+
+	//ǰѴ
+	std::size_t _handled_requests = 0;
+	bool _closed = false;
 
-	std::string _get_url;
+	//·(ѯ)_request.target()
+	std::string_view _get_url;
 };
 
+std::string UrlDecode(std::string_view str);
+
@@ -0,0 +1,304 @@
+#include "JsonCodec.h"
+#include <charconv>
+
+namespace {
+    void AppendUtf8(std::string& out, unsigned int cp) {
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        }
+        else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    bool ParseHex4(std::string_view json, std::size_t pos, unsigned int& cp) {
+        if (pos + 4 > json.size()) {
+            return false;
+        }
+        cp = 0;
+        for (std::size_t i = pos; i < pos + 4; ++i) {
+            char c = json[i];
+            cp <<= 4;
+            if (c >= '0' && c <= '9') cp |= c - '0';
+            else if (c >= 'a' && c <= 'f') cp |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') cp |= c - 'A' + 10;
+            else return false;
+        }
+        return true;
+    }
+}
+
+void JsonReader::SkipWhitespace() {
+    while (_pos < _json.size()) {
+        char c = _json[_pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        ++_pos;
+    }
+}
+
+bool JsonReader::Consume(char c) {
+    if (_pos < _json.size() && _json[_pos] == c) {
+        ++_pos;
+        return true;
+    }
+    return false;
+}
+
+bool JsonReader::ReadKey(std::string_view& key) {
+    if (_pos >= _json.size() || _json[_pos] != '"') {
+        return false;
+    }
+    //常见情况key没有转义字符，直接引用原始数据
+    auto end = _json.find_first_of("\"\\", _pos + 1);
+    if (end != std::string_view::npos && _json[end] == '"') {
+        key = _json.substr(_pos + 1, end - _pos - 1);
+        _pos = end + 1;
+        return true;
+    }
+    if (!ReadString(_keyScratch)) {
+        return false;
+    }
+    key = _keyScratch;
+    return true;
+}
+
+bool JsonReader::ReadString(std::string& out) {
+    out.clear();
+    if (!Consume('"')) {
+        _error = true;
+        return false;
+    }
+    while (_pos < _json.size()) {
+        auto end = _json.find_first_of("\"\\", _pos);
+        if (end == std::string_view::npos) {
+            break;
+        }
+        out.append(_json.data() + _pos, end - _pos);
+        _pos = end;
+        if (_json[_pos] == '"') {
+            ++_pos;
+            return true;
+        }
+        //转义字符
+        if (++_pos >= _json.size()) {
+            break;
+        }
+        char c = _json[_pos++];
+        switch (c) {
+        case '"': out.push_back('"'); break;
+        case '\\': out.push_back('\\'); break;
+        case '/': out.push_back('/'); break;
+        case 'b': out.push_back('\b'); break;
+        case 'f': out.push_back('\f'); break;
+        case 'n': out.push_back('\n'); break;
+        case 'r': out.push_back('\r'); break;
+        case 't': out.push_back('\t'); break;
+        case 'u': {
+            unsigned int cp = 0;
+            if (!ParseHex4(_json, _pos, cp)) {
+                _error = true;
+                return false;
+            }
+            _pos += 4;
+            //UTF-16代理对
+            if (cp >= 0xD800 && cp <= 0xDBFF && _pos + 6 <= _json.size() &&
+                _json[_pos] == '\\' && _json[_pos + 1] == 'u') {
+                unsigned int low = 0;
+                if (ParseHex4(_json, _pos + 2, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    _pos += 6;
+                }
+            }
+            AppendUtf8(out, cp);
+            break;
+        }
+        default:
+            _error = true;
+            return false;
+        }
+    }
+    _error = true;
+    return false;
+}
+
+bool JsonReader::ReadInt(int64_t& out) {
+    auto begin = _json.data() + _pos;
+    auto result = std::from_chars(begin, _json.data() + _json.size(), out);
+    if (result.ec != std::errc()) {
+        _error = true;
+        return false;
+    }
+    _pos += result.ptr - begin;
+    return true;
+}
+
+bool JsonReader::SkipString() {
+    ++_pos;
+    while (_pos < _json.size()) {
+        char c = _json[_pos++];
+        if (c == '\\') {
+            ++_pos;
+        }
+        else if (c == '"') {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JsonReader::Skip() {
+    if (_pos >= _json.size()) {
+        return false;
+    }
+    char c = _json[_pos];
+    if (c == '"') {
+        return SkipString();
+    }
+    if (c == '{' || c == '[') {
+        int depth = 0;
+        while (_pos < _json.size()) {
+            c = _json[_pos];
+            if (c == '"') {
+                if (!SkipString()) {
+                    return false;
+                }
+                continue;
+            }
+            ++_pos;
+            if (c == '{' || c == '[') {
+                ++depth;
+            }
+            else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+    //数字、true、false、null
+    std::size_t start = _pos;
+    while (_pos < _json.size()) {
+        c = _json[_pos];
+        if (c == ',' || c == '}' || c == ']' || c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            break;
+        }
+        ++_pos;
+    }
+    return _pos > start;
+}
+
+void JsonWriter::Separator() {
+    if (_needComma) {
+        _out.push_back(',');
+    }
+}
+
+JsonWriter& JsonWriter::BeginObject() {
+    Separator();
+    _out.push_back('{');
+    _needComma = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndObject() {
+    _out.push_back('}');
+    _needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::BeginArray() {
+    Separator();
+    _out.push_back('[');
+    _needComma = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndArray() {
+    _out.push_back(']');
+    _needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::Key(std::string_view key) {
+    Separator();
+    _out.push_back('"');
+    AppendEscaped(key);
+    _out.append("\":", 2);
+    _needComma = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::String(std::string_view value) {
+    Separator();
+    _out.push_back('"');
+    AppendEscaped(value);
+    _out.push_back('"');
+    _needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::Int(int64_t value) {
+    Separator();
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    _out.append(buf, result.ptr - buf);
+    _needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::UInt(uint64_t value) {
+    Separator();
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    _out.append(buf, result.ptr - buf);
+    _needComma = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::Bool(bool value) {
+    Separator();
+    _out.append(value ? "true" : "false");
+    _needComma = true;
+    return *this;
+}
+
+void JsonWriter::AppendEscaped(std::string_view value) {
+    static const char* hex = "0123456789abcdef";
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(value[i]);
+        if (c != '"' && c != '\\' && c >= 0x20) {
+            continue;
+        }
+        _out.append(value.data() + start, i - start);
+        start = i + 1;
+        switch (c) {
+        case '"': _out.append("\\\"", 2); break;
+        case '\\': _out.append("\\\\", 2); break;
+        case '\n': _out.append("\\n", 2); break;
+        case '\r': _out.append("\\r", 2); break;
+        case '\t': _out.append("\\t", 2); break;
+        default: {
+            char buf[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0F] };
+            _out.append(buf, 6);
+            break;
+        }
+        }
+    }
+    _out.append(value.data() + start, value.size() - start);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+//网关热路径上的轻量JSON编解码，不构造Json::Value。
+//JsonReader按需扫描顶层对象，字段直接解析进请求结构体；
+//JsonWriter把紧凑格式的JSON直接追加到应答体中。
+class JsonReader
+{
+public:
+    explicit JsonReader(std::string_view json) : _json(json) {}
+
+    //遍历顶层对象的字段。回调里可以用ReadString/ReadInt读取当前字段的值，
+    //回调没有读取的值会被自动跳过。返回false表示JSON格式错误。
+    template <typename Func>
+    bool ForEachField(Func&& func) {
+        SkipWhitespace();
+        if (!Consume('{')) {
+            return false;
+        }
+        SkipWhitespace();
+        if (Consume('}')) {
+            return true;
+        }
+        while (true) {
+            std::string_view key;
+            if (!ReadKey(key)) {
+                return false;
+            }
+            SkipWhitespace();
+            if (!Consume(':')) {
+                return false;
+            }
+            SkipWhitespace();
+            std::size_t valueStart = _pos;
+            func(key);
+            if (_error) {
+                return false;
+            }
+            if (_pos == valueStart && !Skip()) {
+                return false;
+            }
+            SkipWhitespace();
+            if (Consume(',')) {
+                SkipWhitespace();
+                continue;
+            }
+            return Consume('}');
+        }
+    }
+
+    bool ReadString(std::string& out);
+    bool ReadInt(int64_t& out);
+    //跳过当前位置的一个任意类型的值
+    bool Skip();
+
+private:
+    bool ReadKey(std::string_view& key);
+    bool SkipString();
+    void SkipWhitespace();
+    bool Consume(char c);
+
+    std::string_view _json;
+    std::size_t _pos = 0;
+    bool _error = false;
+    //key里带转义字符时才用到
+    std::string _keyScratch;
+};
+
+class JsonWriter
+{
+public:
+    explicit JsonWriter(std::string& out) : _out(out) {}
+
+    JsonWriter& BeginObject();
+    JsonWriter& EndObject();
+    JsonWriter& BeginArray();
+    JsonWriter& EndArray();
+    JsonWriter& Key(std::string_view key);
+    JsonWriter& String(std::string_view value);
+    JsonWriter& Int(int64_t value);
+    JsonWriter& UInt(uint64_t value);
+    JsonWriter& Bool(bool value);
+
+private:
+    void Separator();
+    void AppendEscaped(std::string_view value);
+
+    std::string& _out;
+    bool _needComma = false;
+};
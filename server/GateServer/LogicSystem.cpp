@@ -5,6 +5,92 @@
 #include"db/DBManager.h"
 #include "db/UserDAO.h"
 #include "db/UserManager.h"
+#include "db/UserCache.h"
+#include "db/UserWriteBehind.h"
+#include "db/AsyncUserDAO.h"
+#include "db/DBExecutor.h"
+#include "JsonCodec.h"
+
+namespace {
+    //ӿڵṹ壬JsonReaderֱӴJson::Value
+    struct VarifyCodeReq {
+        std::string email;
+
+        bool Parse(std::string_view json) {
+            JsonReader reader(json);
+            return reader.ForEachField([&](std::string_view key) {
+                if (key == "email") reader.ReadString(email);
+            });
+        }
+    };
+
+    struct LoginReq {
+        std::string username;
+        std::string password;
+
+        bool Parse(std::string_view json) {
+            JsonReader reader(json);
+            return reader.ForEachField([&](std::string_view key) {
+                if (key == "username") reader.ReadString(username);
+                else if (key == "password") reader.ReadString(password);
+            });
+        }
+    };
+
+    struct RegisterReq {
+        std::string username;
+        std::string email;
+        std::string password;
+        std::string verify_code;
+
+        bool Parse(std::string_view json) {
+            JsonReader reader(json);
+            return reader.ForEachField([&](std::string_view key) {
+                if (key == "username") reader.ReadString(username);
+                else if (key == "email") reader.ReadString(email);
+                else if (key == "password") reader.ReadString(password);
+                else if (key == "verify_code") reader.ReadString(verify_code);
+            });
+        }
+    };
+
+    struct FriendPageReq {
+        int64_t uid = 0;
+        int64_t after = 0;
+        int64_t limit = FRIEND_PAGE_DEFAULT_LIMIT;
+        int64_t since = 0;
+        int64_t version = 0;
+
+        bool Parse(std::string_view json) {
+            JsonReader reader(json);
+            return reader.ForEachField([&](std::string_view key) {
+                if (key == "uid") reader.ReadInt(uid);
+                else if (key == "after") reader.ReadInt(after);
+                else if (key == "limit") reader.ReadInt(limit);
+                else if (key == "since") reader.ReadInt(since);
+                else if (key == "version") reader.ReadInt(version);
+            });
+        }
+    };
+
+    //ֻerrorֶεӦ
+    void WriteError(std::string& body, int error) {
+        JsonWriter(body).BeginObject().Key("error").Int(error).EndObject();
+    }
+
+    //ӿ(ͳơ¼)ֻܱ
+    bool IsLocalRequest(HttpConnection& connection) {
+        beast::error_code ec;
+        auto address = connection.GetSocket().remote_endpoint(ec).address();
+        if (ec) {
+            return false;
+        }
+        if (address.is_v6() && address.to_v6().is_v4_mapped()) {
+            return net::ip::make_address_v4(net::ip::v4_mapped, address.to_v6()).is_loopback();
+        }
+        return address.is_loopback();
+    }
+}
 
 LogicSystem::LogicSystem() {
     // ʼݿӳ
@@ -14,212 +100,344 @@ LogicSystem::LogicSystem() {
     }
     
     RegGet("/get_test", [](std::shared_ptr<HttpConnection> connection) {
-        beast::ostream(connection->_response.body()) << "receive get_test req " << std::endl;
+        auto& body = connection->_response.body();
+        body.append("receive get_test req \n");
         int i = 0;
         for (auto& elem : connection->_get_params) {
             i++;
-            beast::ostream(connection->_response.body()) << "param" << i << " key is " << elem.first;
-            beast::ostream(connection->_response.body()) << ", " << " value is " << elem.second << std::endl;
+            body.append("param").append(std::to_string(i)).append(" key is ").append(UrlDecode(elem.first));
+            body.append(",  value is ").append(UrlDecode(elem.second)).append("\n");
+        }
+    });
+
+    //ʱͳƣ/Ӧ建ͷֶεķ䡢RedisӳáûϻСӳдϲݿ̳߳Ŷӡӳعģֻ֤
+    RegGet("/get_stats", [](std::shared_ptr<HttpConnection> connection) {
+        connection->_response.set(http::field::content_type, "text/json");
+        if (!IsLocalRequest(*connection)) {
+            WriteError(connection->_response.body(), ErrorCodes::Forbidden);
+            return;
         }
+        auto allocStats = HttpConnection::GetAllocStats();
+        auto redisStats = RedisMgr::GetInstance()->GetPoolStats();
+        auto cacheStats = UserCache::GetInstance()->getStats();
+        auto writeStats = UserWriteBehind::GetInstance()->getStats();
+        auto dbStats = DBExecutor::GetInstance()->getStats();
+        auto poolStats = gDBManager.getPoolStats();
+        auto replicaStats = gDBManager.getReplicaStats();
+        auto verifyStats = VerifyGrpcClient::GetInstance()->GetStats();
+        JsonWriter(connection->_response.body()).BeginObject()
+            .Key("error").Int(ErrorCodes::Success)
+            .Key("body_requests").UInt(allocStats.requests)
+            .Key("body_allocations").UInt(allocStats.bodyAllocations)
+            .Key("header_allocations").UInt(allocStats.headerAllocations)
+            .Key("redis_acquires").UInt(redisStats.acquires)
+            .Key("redis_pinned_hits").UInt(redisStats.pinnedHits)
+            .Key("redis_waits").UInt(redisStats.waits)
+            .Key("redis_wait_time_us").UInt(redisStats.waitTimeUs)
+            .Key("user_cache_local_hits").UInt(cacheStats.localHits)
+            .Key("user_cache_redis_hits").UInt(cacheStats.redisHits)
+            .Key("user_cache_misses").UInt(cacheStats.misses)
+            .Key("write_behind_enqueued").UInt(writeStats.enqueued)
+            .Key("write_behind_flushed_rows").UInt(writeStats.flushedRows)
+            .Key("write_behind_batches").UInt(writeStats.batches)
+            .Key("write_behind_failures").UInt(writeStats.failures)
+            .Key("write_behind_dropped").UInt(writeStats.dropped)
+            .Key("db_executor_submitted").UInt(dbStats.submitted)
+            .Key("db_executor_rejected").UInt(dbStats.rejected)
+            .Key("db_executor_pending").UInt(dbStats.pending)
+            .Key("db_pool_total").Int(poolStats.totalConnections)
+            .Key("db_pool_active").Int(poolStats.activeConnections)
+            .Key("db_pool_idle").Int(poolStats.idleConnections)
+            .Key("db_pool_waiting").Int(poolStats.waitingThreads)
+            .Key("db_pool_target_idle").Int(poolStats.targetIdle)
+            .Key("db_pool_max").Int(poolStats.maxSize)
+            .Key("db_replicas").Int(replicaStats.replicas)
+            .Key("db_replicas_healthy").Int(replicaStats.healthy)
+            .Key("db_replica_reads").UInt(replicaStats.reads)
+            .Key("db_replica_fallbacks").UInt(replicaStats.fallbacks)
+            .Key("verify_calls").UInt(verifyStats.calls)
+            .Key("verify_failures").UInt(verifyStats.failures)
+            .Key("verify_inflight").UInt(verifyStats.inflight)
+            .Key("verify_retries").UInt(verifyStats.retries)
+            .Key("verify_hedges").UInt(verifyStats.hedges)
+            .Key("verify_budget_exhausted").UInt(verifyStats.budgetExhausted)
+            .Key("verify_endpoints").Int(verifyStats.endpoints)
+            .Key("verify_endpoints_healthy").Int(verifyStats.healthy)
+            .Key("verify_ejections").UInt(verifyStats.ejections)
+            .EndObject();
     });
 
-    RegPost("/get_varifycode", [](std::shared_ptr<HttpConnection> connection) {
-        auto body_str = boost::beast::buffers_to_string(connection->_request.body().data());
+    //¶ȡconfig.iniӳصޡʱݲӦõеӳء
+    //޸ķ״̬POSTֻ
+    RegPost("/reload_config", [](std::shared_ptr<HttpConnection> connection) {
+        connection->_response.set(http::field::content_type, "text/json");
+        if (!IsLocalRequest(*connection)) {
+            WriteError(connection->_response.body(), ErrorCodes::Forbidden);
+            return;
+        }
+        bool ok = gDBManager.reloadPoolConfig();
+        WriteError(connection->_response.body(), ok ? ErrorCodes::Success : ErrorCodes::ConfigReloadFailed);
+    });
+
+    RegPost("/get_varifycode", AsyncHttpHandler([](std::shared_ptr<HttpConnection> connection) -> net::awaitable<void> {
+        //ֱյϽٿ
+        const std::string& body_str = connection->_request.body();
         std::cout << "receive body is " << body_str << std::endl;
         connection->_response.set(http::field::content_type, "text/json");
-        Json::Value root;
-        Json::Reader reader;
-        Json::Value src_root;
-        bool parse_success = reader.parse(body_str, src_root);
-        if (!parse_success) {
+        auto& body = connection->_response.body();
+        VarifyCodeReq req;
+        if (!req.Parse(body_str)) {
             std::cout << "Failed to parse JSON data!" << std::endl;
-            root["error"] = ErrorCodes::Error_Json;
-            std::string jsonstr = root.toStyledString();
-            beast::ostream(connection->_response.body()) << jsonstr;
-            return true;
-        }
-
-        auto email = src_root["email"].asString();
-        GetVarifyRsp rsp = VerifyGrpcClient::GetInstance()->GetVarifyCode(email);
-        std::cout << "email is " << email << std::endl;
-        root["error"] = rsp.error();
-        root["email"] = src_root["email"];
-        std::string jsonstr = root.toStyledString();
-        beast::ostream(connection->_response.body()) << jsonstr;
-        return true;
-    });
+            WriteError(body, ErrorCodes::Error_Json);
+            co_return;
+        }
+
+        //첽gRPCãȴڼ䲻ռio_contextֹ̺̳̣߳߳߳ʱ䲻HTTPĽֹʱ
+        GetVarifyRsp rsp = co_await VerifyGrpcClient::GetInstance()->AsyncGetVarifyCode(req.email,
+            connection->GetRequestDeadline());
+        std::cout << "email is " << req.email << std::endl;
+        JsonWriter(body).BeginObject()
+            .Key("error").Int(rsp.error())
+            .Key("email").String(req.email)
+            .EndObject();
+        co_return;
+    }));
 
-    RegPost("/login", [](std::shared_ptr<HttpConnection> connection) {
-        auto body_str = boost::beast::buffers_to_string(connection->_request.body().data());
+    RegPost("/login", AsyncHttpHandler([](std::shared_ptr<HttpConnection> connection) -> net::awaitable<void> {
+        //ֱյϽٿ
+        const std::string& body_str = connection->_request.body();
         std::cout << "receive login request body: " << body_str << std::endl;
         connection->_response.set(http::field::content_type, "text/json");
-        
-        Json::Value root;
-        Json::Reader reader;
-        Json::Value src_root;
-        bool parse_success = reader.parse(body_str, src_root);
-        if (!parse_success) {
+        auto& body = connection->_response.body();
+
+        LoginReq req;
+        if (!req.Parse(body_str)) {
             std::cout << "Failed to parse JSON data!" << std::endl;
-            root["error"] = ErrorCodes::Error_Json;
-            std::string jsonstr = root.toStyledString();
-            beast::ostream(connection->_response.body()) << jsonstr;
-            return true;
+            WriteError(body, ErrorCodes::Error_Json);
+            co_return;
         }
 
-        // ȡ
-        auto username = src_root["username"].asString();
-        auto password = src_root["password"].asString();
-
         // ֤
-        if (username.empty() || password.empty()) {
-            root["error"] = ErrorCodes::InvalidParams;
-            std::string jsonstr = root.toStyledString();
-            beast::ostream(connection->_response.body()) << jsonstr;
-            return true;
+        if (req.username.empty() || req.password.empty()) {
+            WriteError(body, ErrorCodes::InvalidParams);
+            co_return;
         }
 
-        // ֤û
-        auto result = UserManager::GetInstance()->login(username, password);
+        // ֤û룬нݿ̳߳أʱֱӷطæ
+        auto loginResult = co_await DBExecutor::GetInstance()->TryRun([username = req.username, password = req.password] {
+            return UserManager::GetInstance()->login(username, password);
+        });
+        if (!loginResult) {
+            WriteError(body, ErrorCodes::DB_BUSY);
+            co_return;
+        }
         
+        auto& result = *loginResult;
         if (result.getCode() == ResultCode::SUCCESS) {
-            // ¼ɹ
+            // ¼ɹûϢװuserInfo
             auto user = result.getData();
-            root["error"] = ErrorCodes::Success;
-            
-            // ûϢװuserInfo
-            Json::Value userInfo;
-            userInfo["userId"] = Json::Int(user->userId);
-            userInfo["username"] = user->username;
-            userInfo["nickname"] = user->nickname;
-            userInfo["avatar"] = user->avatar;
-            userInfo["email"] = user->email;
-            userInfo["status"] = user->status;
-            
-            root["userInfo"] = userInfo;
+            JsonWriter(body).BeginObject()
+                .Key("error").Int(ErrorCodes::Success)
+                .Key("userInfo").BeginObject()
+                    .Key("userId").Int(user->userId)
+                    .Key("username").String(user->username)
+                    .Key("nickname").String(user->nickname)
+                    .Key("avatar").String(user->avatar)
+                    .Key("email").String(user->email)
+                    .Key("status").String(userStatusName(user->status))
+                .EndObject()
+                .EndObject();
             
             // tokenͻˣԱ֤
             // TODO: tokenɺ͹߼
         } else if (result.getCode() == ResultCode::INVALID_PASSWORD) {
             // 
-            root["error"] = ErrorCodes::USER_INVALID_PASSWORD;  // ˴
+            WriteError(body, ErrorCodes::USER_INVALID_PASSWORD);  // ˴
         } else if (result.getCode() == ResultCode::USER_NOT_FOUND) {
             // û
-            root["error"] = ErrorCodes::USER_NOT_FOUND;  // ˴
+            WriteError(body, ErrorCodes::USER_NOT_FOUND);  // ˴
         } else {
             // 
             std::cout << "¼ʧܣϢ: " << result.getMessage() << std::endl;
-            root["error"] = ErrorCodes::USER_LOGIN_FAILED;
+            WriteError(body, ErrorCodes::USER_LOGIN_FAILED);
         }
+        co_return;
+    }));
 
-        std::string jsonstr = root.toStyledString();
-        beast::ostream(connection->_response.body()) << jsonstr;
-        return true;
-    });
+    //бҳafterΪһҳnextsinceΪϴͬʱversion(0ʾȫ)
+    //versionΪͬһҳصversion(һҳ)һͬҳͬһversion
+    //ÿݿֱ߳дӦ壬ڴбб
+    RegPost("/get_friend_list", AsyncHttpHandler([](std::shared_ptr<HttpConnection> connection) -> net::awaitable<void> {
+        const std::string& body_str = connection->_request.body();
+        connection->_response.set(http::field::content_type, "text/json");
+        auto& body = connection->_response.body();
 
-    RegPost("/register", [](std::shared_ptr<HttpConnection> connection) {
-        auto body_str = boost::beast::buffers_to_string(connection->_request.body().data());
+        FriendPageReq req;
+        if (!req.Parse(body_str)) {
+            std::cout << "Failed to parse JSON data!" << std::endl;
+            WriteError(body, ErrorCodes::Error_Json);
+            co_return;
+        }
+        if (req.uid <= 0 || req.after < 0 || req.since < 0 || req.version < 0) {
+            WriteError(body, ErrorCodes::InvalidParams);
+            co_return;
+        }
+
+        JsonWriter writer(body);
+        writer.BeginObject()
+            .Key("error").Int(ErrorCodes::Success)
+            .Key("friends").BeginArray();
+        AsyncUserDAO userDao;
+        auto result = co_await userDao.getFriendPage(req.uid, req.after, static_cast<int>(req.limit), req.since, req.version,
+            [&writer](const FriendRow& row) {
+                writer.BeginObject().Key("uid").Int(row.userId);
+                if (row.removed) {
+                    writer.Key("removed").Bool(true);
+                } else {
+                    writer.Key("username").String(row.username)
+                        .Key("nickname").String(row.nickname)
+                        .Key("avatar").String(row.avatar)
+                        .Key("status").String(userStatusName(row.status));
+                }
+                writer.EndObject();
+            });
+
+        if (!result.isSuccess()) {
+            //ѾдĲϣֻش
+            std::cout << "ȡбʧܣϢ: " << result.getMessage() << std::endl;
+            body.clear();
+            WriteError(body, result.getMessage() == AsyncUserDAO::DB_BUSY_MESSAGE
+                ? ErrorCodes::DB_BUSY : ErrorCodes::DB_QUERY_FAILED);
+            co_return;
+        }
+        auto page = result.getData();
+        writer.EndArray()
+            .Key("next").Int(page->lastId)
+            .Key("has_more").Bool(page->hasMore)
+            .Key("version").Int(page->version)
+            .EndObject();
+        co_return;
+    }));
+
+    RegPost("/register", AsyncHttpHandler([](std::shared_ptr<HttpConnection> connection) -> net::awaitable<void> {
+        //ֱյϽٿ
+        const std::string& body_str = connection->_request.body();
         std::cout << "receive register request body: " << body_str << std::endl;
         connection->_response.set(http::field::content_type, "text/json");
-        
-        Json::Value root;
-        Json::Reader reader;
-        Json::Value src_root;
-        bool parse_success = reader.parse(body_str, src_root);
-        if (!parse_success) {
+        auto& body = connection->_response.body();
+
+        RegisterReq req;
+        if (!req.Parse(body_str)) {
             std::cout << "Failed to parse JSON data!" << std::endl;
-            root["error"] = ErrorCodes::Error_Json;
-            std::string jsonstr = root.toStyledString();
-            beast::ostream(connection->_response.body()) << jsonstr;
-            return true;
+            WriteError(body, ErrorCodes::Error_Json);
+            co_return;
         }
 
-        // ȡ
-        auto username = src_root["username"].asString();
-        auto email = src_root["email"].asString();
-        auto password = src_root["password"].asString();
-        auto verify_code = src_root["verify_code"].asString();
-
         // ֤
-        if (username.empty() || email.empty() || password.empty() || verify_code.empty()) {
-            root["error"] = ErrorCodes::InvalidParams;
-            std::string jsonstr = root.toStyledString();
-            beast::ostream(connection->_response.body()) << jsonstr;
-            return true;
-        }
-
-        // ֤֤
-        auto redisMgr = RedisMgr::GetInstance();
-        std::string stored_code;
-        if (!redisMgr->Get("code:" + email, stored_code)) {
-            root["error"] = ErrorCodes::TokenInvalid;  // ֤벻ڻѹ
-            std::string jsonstr = root.toStyledString();
-            beast::ostream(connection->_response.body()) << jsonstr;
-            return true;
+        if (req.username.empty() || req.email.empty() || req.password.empty() || req.verify_code.empty()) {
+            WriteError(body, ErrorCodes::InvalidParams);
+            co_return;
         }
-        
-        if (stored_code != verify_code) {
-            root["error"] = ErrorCodes::TokenInvalid;  // ֤벻ƥ
-            std::string jsonstr = root.toStyledString();
-            beast::ostream(connection->_response.body()) << jsonstr;
-            return true;
+
+        // ֤֤룺ȽϺɾRedisԭɣһֻ֤ܳɹʹһΣ
+        // ע󲻻ͬʱͨУ顣֤벻ڡѹڻƥʱTokenInvalid
+        //첽Redisͻˣֱڵǰio_contextϵȴӦ
+        bool code_ok = co_await RedisMgr::GetInstance()->AsyncCheckAndDel("code:" + req.email, req.verify_code);
+        if (!code_ok) {
+            WriteError(body, ErrorCodes::TokenInvalid);
+            co_return;
         }
 
         // ûʵ
         UserEntity user;
-        user.username = username;  // ʹÿͻ˴û
-        user.password = password;  // ע⣺ʵӦӦöйϣ
-        user.nickname = username;  // ĬʹusernameΪnickname
-        user.email = email;        // Ϣ
-        user.status = "offline";   // ʹַ͵״̬ݿENUM
+        user.username = req.username;  // ʹÿͻ˴û
+        user.password = req.password;  // ע⣺ʵӦӦöйϣ
+        user.nickname = req.username;  // ĬʹusernameΪnickname
+        user.email = req.email;        // Ϣ
+        user.status = UserStatus::OFFLINE;
         user.avatar = "default.png";  // Ĭͷ񣬱ֵ
 
-        UserDAO userDao;
-        auto result = userDao.addUser(user);
+        //ݿд뽻DBExecutor̳߳ʱֱӷʧ
+        AsyncUserDAO userDao;
+        auto result = co_await userDao.addUser(user);
 
         if (result.isSuccess()) {
-            redisMgr->Del("code:" + email);  // עɹɾ֤
-            root["error"] = ErrorCodes::Success;
+            WriteError(body, ErrorCodes::Success);
         } else {
             if (result.getMessage().find("Duplicate entry") != std::string::npos) {
-                root["error"] = ErrorCodes::USER_ALREADY_EXISTS;
+                WriteError(body, ErrorCodes::USER_ALREADY_EXISTS);
+            } else if (result.getMessage() == AsyncUserDAO::DB_BUSY_MESSAGE) {
+                WriteError(body, ErrorCodes::DB_BUSY);
             } else {
                 // ϸĴ־
                 std::cout << "ûעʧܣϢ: " << result.getMessage() << std::endl;
-                root["error"] = ErrorCodes::USER_REGISTER_FAILED;
+                WriteError(body, ErrorCodes::USER_REGISTER_FAILED);
             }
         }
-
-        std::string jsonstr = root.toStyledString();
-        beast::ostream(connection->_response.body()) << jsonstr;
-        return true;
-    });
+        co_return;
+    }));
 }
 
 
 void LogicSystem::RegGet(std::string url, HttpHandler handler) {
-    _get_handlers.insert(make_pair(url, handler));
+    _routes.Add(http::verb::get, url).handler = handler;
+}
+
+void LogicSystem::RegGet(std::string url, AsyncHttpHandler handler) {
+    _routes.Add(http::verb::get, url).asyncHandler = handler;
 }
 
 void LogicSystem::RegPost(std::string url, HttpHandler handler)
 {
-    _post_handlers.insert(make_pair(url, handler));
+    _routes.Add(http::verb::post, url).handler = handler;
 }
 
-bool LogicSystem::HandlePost(std::string path, std::shared_ptr<HttpConnection> con)
+void LogicSystem::RegPost(std::string url, AsyncHttpHandler handler)
 {
-    if (_post_handlers.find(path) == _post_handlers.end())
+    _routes.Add(http::verb::post, url).asyncHandler = handler;
+}
+
+bool LogicSystem::HandlePost(std::string_view path, std::shared_ptr<HttpConnection> con)
+{
+    auto route = _routes.Find(http::verb::post, path, con->_path_params);
+    if (route == nullptr)
     {
         return false;
     }
-    _post_handlers[path](con);
+    Dispatch(*route, con);
     return true;
 }
 
-bool LogicSystem::HandleGet(std::string path, std::shared_ptr<HttpConnection> con) {
-    if (_get_handlers.find(path) == _get_handlers.end()) {
+bool LogicSystem::HandleGet(std::string_view path, std::shared_ptr<HttpConnection> con) {
+    auto route = _routes.Find(http::verb::get, path, con->_path_params);
+    if (route == nullptr) {
         return false;
     }
-	//ֱӵעĺ
-    _get_handlers[path](con);
+    Dispatch(*route, con);
     return true;
-}
\ No newline at end of file
+}
+
+void LogicSystem::Dispatch(RouteHandler& route, std::shared_ptr<HttpConnection> con) {
+    if (route.asyncHandler) {
+        //Эhandlerڵio_contextУдӦ
+        net::co_spawn(con->GetSocket().get_executor(), route.asyncHandler(con),
+            [con](std::exception_ptr e) {
+                if (e) {
+                    try {
+                        std::rethrow_exception(e);
+                    }
+                    catch (std::exception& exp) {
+                        std::cout << "async handler exception: " << exp.what() << std::endl;
+                    }
+                    catch (...) {
+                        std::cout << "async handler unknown exception" << std::endl;
+                    }
+                }
+                con->CompleteReq(!e);
+            });
+        return;
+    }
+    //ֱӵעĺ
+    route.handler(con);
+    con->CompleteReq(true);
+}
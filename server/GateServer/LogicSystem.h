@@ -1,20 +1,23 @@
 #pragma once
 #include"Singleton.h"
 #include "const.h"
-class HttpConnection;
-typedef std::function<void(std::shared_ptr<HttpConnection>)> HttpHandler;
+#include "RouteTable.h"
 class LogicSystem : public Singleton<LogicSystem>	
 {
     friend class Singleton<LogicSystem>;
 public:
     ~LogicSystem() {};
-    bool HandleGet(std::string url, std::shared_ptr<HttpConnection>);
+    bool HandleGet(std::string_view url, std::shared_ptr<HttpConnection>);
+    //url支持 {name} 形式的路径参数，如 /user/{id}
     void RegGet(std::string url, HttpHandler handler);
+    void RegGet(std::string url, AsyncHttpHandler handler);
 	void RegPost(std::string url, HttpHandler handler);
-    bool HandlePost(std::string url, std::shared_ptr<HttpConnection>);
+	void RegPost(std::string url, AsyncHttpHandler handler);
+    bool HandlePost(std::string_view url, std::shared_ptr<HttpConnection>);
 
 private:
     LogicSystem();
-    std::map<std::string, HttpHandler> _post_handlers;
-    std::map<std::string, HttpHandler> _get_handlers;
+    //执行路由handler，完成后由HttpConnection写回应答
+    void Dispatch(RouteHandler& route, std::shared_ptr<HttpConnection> con);
+    RouteTable _routes;
 }; 
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "RedisAsyncConnection.h"
+
+namespace {
+    //随命令一起交给hiredis的私有数据，应答到达后释放
+    struct PendingCommand {
+        RedisAsyncConnection* connection;
+        RedisCallback callback;
+    };
+}
+
+RedisAsyncConnection::RedisAsyncConnection(net::io_context& ioc, const std::string& host, int port, const std::string& pwd)
+    : _ioc(ioc), _socket(ioc), _host(host), _port(port), _pwd(pwd) {
+}
+
+RedisAsyncConnection::~RedisAsyncConnection() {
+    _closing = true;
+    if (_ctx != nullptr) {
+        //会以空应答回调所有未完成的命令，并调用OnCleanup
+        redisAsyncFree(_ctx);
+        _ctx = nullptr;
+    }
+}
+
+bool RedisAsyncConnection::Connect() {
+    _ctx = redisAsyncConnect(_host.c_str(), _port);
+    if (_ctx == nullptr || _ctx->err) {
+        std::cout << "redis async connect failed: " << (_ctx ? _ctx->errstr : "alloc error") << std::endl;
+        if (_ctx != nullptr) {
+            redisAsyncFree(_ctx);
+            _ctx = nullptr;
+        }
+        return false;
+    }
+
+    boost::system::error_code ec;
+    _socket.assign(tcp::v4(), _ctx->c.fd, ec);
+    if (ec) {
+        std::cout << "redis async assign socket failed: " << ec.message() << std::endl;
+        redisAsyncFree(_ctx);
+        _ctx = nullptr;
+        return false;
+    }
+
+    _ctx->data = this;
+    _ctx->ev.data = this;
+    _ctx->ev.addRead = &RedisAsyncConnection::OnAddRead;
+    _ctx->ev.delRead = &RedisAsyncConnection::OnDelRead;
+    _ctx->ev.addWrite = &RedisAsyncConnection::OnAddWrite;
+    _ctx->ev.delWrite = &RedisAsyncConnection::OnDelWrite;
+    _ctx->ev.cleanup = &RedisAsyncConnection::OnCleanup;
+    redisAsyncSetDisconnectCallback(_ctx, &RedisAsyncConnection::OnDisconnect);
+
+    //AUTH排在所有命令之前，连接建立后第一个发送
+    if (!_pwd.empty()) {
+        Command({ "AUTH", _pwd }, [](RedisValue value) {
+            if (!value.IsOk()) {
+                std::cout << "redis async auth failed: " << value.str << std::endl;
+            }
+        });
+    }
+    return true;
+}
+
+void RedisAsyncConnection::Command(const std::vector<std::string>& args, RedisCallback callback) {
+    if (_ctx == nullptr) {
+        callback(RedisValue());
+        return;
+    }
+
+    //命令编码进本线程复用的缓冲，hiredis会把它拷进自己的输出缓冲
+    thread_local std::string buffer;
+    buffer.clear();
+    RespEncoder::AppendRange(buffer, args);
+
+    auto* pending = new PendingCommand{ this, std::move(callback) };
+    int status = redisAsyncFormattedCommand(_ctx, &RedisAsyncConnection::OnReply, pending,
+        buffer.data(), buffer.size());
+    if (status != REDIS_OK) {
+        auto cb = std::move(pending->callback);
+        delete pending;
+        cb(RedisValue());
+    }
+}
+
+void RedisAsyncConnection::OnReply(redisAsyncContext*, void* reply, void* privdata) {
+    std::unique_ptr<PendingCommand> pending(static_cast<PendingCommand*>(privdata));
+    //连接关闭时未完成的命令也要以空应答完成，否则等待它的协程永远不会恢复
+    RedisValue value;
+    if (!pending->connection->_closing) {
+        //reply在回调返回后由hiredis释放，先转换成RedisValue
+        value = RedisValue::FromReply(static_cast<redisReply*>(reply));
+    }
+    //io_context已经停止时投递的回调不会再执行，直接调用
+    auto& ioc = pending->connection->_ioc;
+    if (ioc.stopped()) {
+        pending->callback(std::move(value));
+        return;
+    }
+    //投递回io_context，避免在hiredis的读处理流程里重入
+    net::post(ioc,
+        [callback = std::move(pending->callback), value = std::move(value)]() mutable {
+            callback(std::move(value));
+        });
+}
+
+void RedisAsyncConnection::OnDisconnect(const redisAsyncContext* ac, int status) {
+    auto* self = static_cast<RedisAsyncConnection*>(ac->data);
+    if (status != REDIS_OK) {
+        std::cout << "redis async connection lost: " << ac->errstr << std::endl;
+    }
+    //hiredis随后会自己释放上下文
+    self->_ctx = nullptr;
+}
+
+void RedisAsyncConnection::OnAddRead(void* data) {
+    auto* self = static_cast<RedisAsyncConnection*>(data);
+    self->_reading = true;
+    self->WaitRead();
+}
+
+void RedisAsyncConnection::OnDelRead(void* data) {
+    static_cast<RedisAsyncConnection*>(data)->_reading = false;
+}
+
+void RedisAsyncConnection::OnAddWrite(void* data) {
+    auto* self = static_cast<RedisAsyncConnection*>(data);
+    self->_writing = true;
+    self->WaitWrite();
+}
+
+void RedisAsyncConnection::OnDelWrite(void* data) {
+    static_cast<RedisAsyncConnection*>(data)->_writing = false;
+}
+
+void RedisAsyncConnection::OnCleanup(void* data) {
+    auto* self = static_cast<RedisAsyncConnection*>(data);
+    self->_reading = false;
+    self->_writing = false;
+    self->_ctx = nullptr;
+    //fd由hiredis关闭，这里只解除asio对它的管理
+    boost::system::error_code ec;
+    self->_socket.cancel(ec);
+    self->_socket.release(ec);
+}
+
+void RedisAsyncConnection::WaitRead() {
+    if (!_reading || _readWaiting || _ctx == nullptr) {
+        return;
+    }
+    _readWaiting = true;
+    auto self = shared_from_this();
+    _socket.async_wait(tcp::socket::wait_read, [self](boost::system::error_code ec) {
+        self->_readWaiting = false;
+        if (ec || self->_ctx == nullptr) {
+            return;
+        }
+        redisAsyncHandleRead(self->_ctx);
+        self->WaitRead();
+    });
+}
+
+void RedisAsyncConnection::WaitWrite() {
+    if (!_writing || _writeWaiting || _ctx == nullptr) {
+        return;
+    }
+    _writeWaiting = true;
+    auto self = shared_from_this();
+    _socket.async_wait(tcp::socket::wait_write, [self](boost::system::error_code ec) {
+        self->_writeWaiting = false;
+        if (ec || self->_ctx == nullptr) {
+            return;
+        }
+        redisAsyncHandleWrite(self->_ctx);
+        self->WaitWrite();
+    });
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "const.h"
+#include "RedisValue.h"
+#include "RespEncoder.h"
+#include<async.h>
+
+typedef std::function<void(RedisValue)> RedisCallback;
+
+//把hiredis的redisAsyncContext挂到boost::asio::io_context上：
+//socket的读写就绪由io_context通知，再交给redisAsyncHandleRead/Write处理。
+//所有方法都必须在所属io_context的线程上调用，回调也在该线程上执行。
+class RedisAsyncConnection : public std::enable_shared_from_this<RedisAsyncConnection>
+{
+public:
+    RedisAsyncConnection(net::io_context& ioc, const std::string& host, int port, const std::string& pwd);
+    ~RedisAsyncConnection();
+
+    bool Connect();
+    bool IsConnected() const { return _ctx != nullptr; }
+    //发送一条命令，参数按二进制安全的方式传递
+    void Command(const std::vector<std::string>& args, RedisCallback callback);
+
+private:
+    static void OnAddRead(void* data);
+    static void OnDelRead(void* data);
+    static void OnAddWrite(void* data);
+    static void OnDelWrite(void* data);
+    static void OnCleanup(void* data);
+    static void OnDisconnect(const redisAsyncContext* ac, int status);
+    static void OnReply(redisAsyncContext* ac, void* reply, void* privdata);
+
+    void WaitRead();
+    void WaitWrite();
+
+    net::io_context& _ioc;
+    tcp::socket _socket;
+    std::string _host;
+    int _port;
+    std::string _pwd;
+    redisAsyncContext* _ctx = nullptr;
+    bool _reading = false;
+    bool _writing = false;
+    bool _readWaiting = false;
+    bool _writeWaiting = false;
+    bool _closing = false;
+};
@@ -0,0 +1,22 @@
+#include "RedisBatch.h"
+
+RedisBatch& RedisBatch::Add(std::initializer_list<std::string_view> args) {
+    RespEncoder::AppendRange(_buffer, args);
+    ++_count;
+    return *this;
+}
+
+RedisBatch& RedisBatch::Add(const std::vector<std::string>& args) {
+    RespEncoder::AppendRange(_buffer, args);
+    ++_count;
+    return *this;
+}
+
+void RedisBatch::Clear() {
+    _buffer.clear();
+    _count = 0;
+}
+
+bool RedisBatch::AppendTo(redisContext* ctx) const {
+    return redisAppendFormattedCommand(ctx, _buffer.data(), _buffer.size()) == REDIS_OK;
+}
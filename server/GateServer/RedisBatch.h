@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <initializer_list>
+#include<hiredis.h>
+#include "RespEncoder.h"
+
+//批量命令构造器：命令在Add时直接编码成RESP，执行时整段追加到连接的输出缓冲，
+//由第一次redisGetReply一次写出，只占用一次往返
+class RedisBatch {
+public:
+    RedisBatch& Add(std::initializer_list<std::string_view> args);
+    RedisBatch& Add(const std::vector<std::string>& args);
+
+    size_t Size() const { return _count; }
+    bool Empty() const { return _count == 0; }
+    //清空命令，保留缓冲区容量以便复用
+    void Clear();
+
+    //把所有命令追加到ctx的输出缓冲，不发生网络I/O
+    bool AppendTo(redisContext* ctx) const;
+
+private:
+    std::string _buffer;
+    size_t _count = 0;
+};
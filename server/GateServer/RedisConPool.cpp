@@ -1,65 +1,166 @@
 #include "RedisConPool.h"
+#include "const.h"
 
-RedisConPool::RedisConPool(size_t poolSize, const char* host, int port, const char* pwd)
-    : poolSize_(poolSize), host_(host), port_(port), b_stop_(false) {
-    for (size_t i = 0; i < poolSize_; ++i) {
-        auto* context = redisConnect(host, port);
-        if (context == nullptr || context->err != 0) {
+namespace {
+    //线程固定连接。线程退出时释放连接。
+    struct PinnedConnection {
+        RedisConPool* owner = nullptr;
+        redisContext* context = nullptr;
+        bool inUse = false;
+
+        ~PinnedConnection() {
             if (context != nullptr) {
                 redisFree(context);
             }
-            continue;
         }
+    };
+
+    thread_local PinnedConnection t_pinned;
+}
 
-        auto reply = (redisReply*)redisCommand(context, "AUTH %s", pwd);
-        if (reply->type == REDIS_REPLY_ERROR) {
-            std::cout << "认证失败" << std::endl;
-            freeReplyObject(reply);
-            continue;
+RedisConPool::RedisConPool(size_t poolSize, const char* host, int port, const char* pwd, bool pinPerThread)
+    : b_stop_(false), poolSize_(poolSize), host_(host), port_(port), pwd_(pwd),
+      pinPerThread_(pinPerThread), connections_(poolSize) {
+    for (size_t i = 0; i < poolSize_; ++i) {
+        auto* context = createConnection();
+        if (context != nullptr) {
+            connections_.TryPush(context);
         }
+    }
+}
 
+redisContext* RedisConPool::createConnection() {
+    auto* context = redisConnect(host_.c_str(), port_);
+    if (context == nullptr || context->err != 0) {
+        if (context != nullptr) {
+            redisFree(context);
+        }
+        return nullptr;
+    }
+
+    auto reply = (redisReply*)redisCommand(context, "AUTH %s", pwd_.c_str());
+    if (reply == nullptr || reply->type == REDIS_REPLY_ERROR) {
+        std::cout << "认证失败" << std::endl;
         freeReplyObject(reply);
-        std::cout << "认证成功" << std::endl;
-        connections_.push(context);
+        redisFree(context);
+        return nullptr;
     }
+
+    freeReplyObject(reply);
+    std::cout << "认证成功" << std::endl;
+    return context;
 }
 
 RedisConPool::~RedisConPool() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    while (!connections_.empty()) {
-        auto* conn = connections_.front();
+    Close();
+    redisContext* conn = nullptr;
+    while (connections_.TryPop(conn)) {
         redisFree(conn);
-        connections_.pop();
     }
 }
 
 redisContext* RedisConPool::getConnection() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    cond_.wait(lock, [this] {
-        if (b_stop_) {
-            return true;
-        }
-        return !connections_.empty();
-    });
     if (b_stop_) {
         return nullptr;
     }
-    auto* context = connections_.front();
-    connections_.pop();
+    ++acquires_;
+
+    //优先使用本线程的固定连接
+    if (pinPerThread_) {
+        if (t_pinned.owner != this) {
+            if (t_pinned.context != nullptr) {
+                redisFree(t_pinned.context);
+            }
+            t_pinned.owner = this;
+            t_pinned.context = createConnection();
+            t_pinned.inUse = false;
+        }
+        //固定连接创建失败或已断开时先重连，重连不上就改用共享连接
+        if (!t_pinned.inUse && reconnect(t_pinned.context)) {
+            t_pinned.inUse = true;
+            ++pinnedHits_;
+            return t_pinned.context;
+        }
+    }
+
+    redisContext* context = nullptr;
+    if (!connections_.TryPop(context)) {
+        context = waitConnection();
+    }
+    //重连不上时仍然借出原来的连接，命令立即失败，归还后下次再试，池中的连接数不变
+    if (context != nullptr) {
+        reconnect(context);
+    }
+    return context;
+}
+
+bool RedisConPool::reconnect(redisContext*& context) {
+    if (context != nullptr && context->err == 0) {
+        return true;
+    }
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    if (now < nextReconnect_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    auto* fresh = createConnection();
+    if (fresh == nullptr) {
+        nextReconnect_.store(now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::milliseconds(REDIS_RECONNECT_INTERVAL_MS)).count(), std::memory_order_relaxed);
+        return false;
+    }
+    if (context != nullptr) {
+        redisFree(context);
+    }
+    context = fresh;
+    return true;
+}
+
+redisContext* RedisConPool::waitConnection() {
+    auto start = std::chrono::steady_clock::now();
+    ++waits_;
+    ++waiters_;
+    redisContext* context = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        //returnConnection在入队之后才加锁通知，所以这里持锁检查队列不会丢失唤醒
+        while (!b_stop_ && !connections_.TryPop(context)) {
+            cond_.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+    --waiters_;
+    waitTimeUs_ += std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    if (b_stop_ && context != nullptr) {
+        redisFree(context);
+        return nullptr;
+    }
     return context;
 }
 
 void RedisConPool::returnConnection(redisContext* context) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (b_stop_) {
+    if (context == nullptr) {
+        return;
+    }
+    if (context == t_pinned.context && t_pinned.owner == this) {
+        t_pinned.inUse = false;
+        return;
+    }
+    if (b_stop_ || !connections_.TryPush(context)) {
         redisFree(context);
         return;
     }
-    connections_.push(context);
-    cond_.notify_one();
+    if (waiters_ > 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cond_.notify_one();
+    }
 }
 
 void RedisConPool::Close() {
     b_stop_ = true;
+    std::lock_guard<std::mutex> lock(mutex_);
     cond_.notify_all();
-} 
\ No newline at end of file
+}
+
+RedisPoolStats RedisConPool::GetStats() const {
+    return RedisPoolStats{ acquires_.load(), pinnedHits_.load(), waits_.load(), waitTimeUs_.load() };
+}
\ No newline at end of file
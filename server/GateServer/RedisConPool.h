@@ -5,22 +5,54 @@
 #include <atomic>
 #include <memory>
 #include <iostream>
+#include <string>
+#include <chrono>
 #include<hiredis.h>
+#include "MPMCQueue.h"
+
+//连接池的争用统计
+struct RedisPoolStats {
+    uint64_t acquires;      // 获取连接总次数
+    uint64_t pinnedHits;    // 直接命中本线程固定连接的次数
+    uint64_t waits;         // 需要等待才拿到连接的次数
+    uint64_t waitTimeUs;    // 累计等待时间(微秒)
+};
 
 class RedisConPool {
 public:
-    RedisConPool(size_t poolSize, const char* host, int port, const char* pwd);
+    //pinPerThread为true时，每个调用线程第一次使用时会额外建立一条固定连接，
+    //之后优先使用这条连接，不经过共享队列；共享队列(poolSize条)作为溢出备用。
+    RedisConPool(size_t poolSize, const char* host, int port, const char* pwd, bool pinPerThread = false);
     ~RedisConPool();
     redisContext* getConnection();
     void returnConnection(redisContext* context);
     void Close();
+    RedisPoolStats GetStats() const;
 
 private:
+    redisContext* createConnection();
+    redisContext* waitConnection();
+    //context为空或已出错(服务器断开等)时换成新建的连接，返回context是否可用。
+    //新建失败时context保持不变，此后REDIS_RECONNECT_INTERVAL_MS内不再尝试，避免每次获取都阻塞在连接上
+    bool reconnect(redisContext*& context);
+
     std::atomic<bool> b_stop_;
     size_t poolSize_;
-    const char* host_;
+    std::string host_;
     int port_;
-    std::queue<redisContext*> connections_;
+    std::string pwd_;
+    bool pinPerThread_;
+    //共享的溢出连接，无锁队列，获取/归还都不加锁
+    MPMCQueue<redisContext*> connections_;
+    //只有队列为空需要等待时才使用
     std::mutex mutex_;
     std::condition_variable cond_;
+    std::atomic<int> waiters_{ 0 };
+    //下次允许重连的时间(steady_clock纳秒)
+    std::atomic<int64_t> nextReconnect_{ 0 };
+
+    std::atomic<uint64_t> acquires_{ 0 };
+    std::atomic<uint64_t> pinnedHits_{ 0 };
+    std::atomic<uint64_t> waits_{ 0 };
+    std::atomic<uint64_t> waitTimeUs_{ 0 };
 }; 
\ No newline at end of file
@@ -1,12 +1,28 @@
 #include "RedisMgr.h"
 #include "ConfigMgr.h"
 
+namespace {
+    const char* CHECK_AND_DEL_SCRIPT =
+        "if redis.call('GET', KEYS[1]) == ARGV[1] then return redis.call('DEL', KEYS[1]) else return 0 end";
+}
+
 RedisMgr::RedisMgr() {
     auto& gCfgMgr = ConfigMgr::Inst();
     auto host = gCfgMgr["Redis"]["Host"];
     auto port = gCfgMgr["Redis"]["Port"];
     auto pwd = gCfgMgr["Redis"]["Passwd"];
-    _con_pool = std::make_unique<RedisConPool>(5, host.c_str(), atoi(port.c_str()), pwd.c_str());
+    auto pool_size_str = gCfgMgr[REDIS_CONFIG_SECTION][REDIS_POOL_SIZE_KEY];
+    int pool_size = pool_size_str.empty() ? REDIS_DEFAULT_POOL_SIZE : atoi(pool_size_str.c_str());
+    if (pool_size <= 0) {
+        pool_size = REDIS_DEFAULT_POOL_SIZE;
+    }
+    bool pin_per_thread = gCfgMgr[REDIS_CONFIG_SECTION][REDIS_PIN_PER_THREAD_KEY] == "true";
+    _con_pool = std::make_unique<RedisConPool>(pool_size, host.c_str(), atoi(port.c_str()), pwd.c_str(), pin_per_thread);
+    _host = host;
+    _port = atoi(port.c_str());
+    _pwd = pwd;
+    _check_and_del.source = CHECK_AND_DEL_SCRIPT;
+    _check_and_del.sha = LoadScript(_check_and_del.source);
 }
 
 RedisMgr::~RedisMgr() {
@@ -17,241 +33,330 @@ void RedisMgr::Close() {
     _con_pool->Close();
 }
 
-bool RedisMgr::Get(const std::string& key, std::string& value)
-{
-    auto connect = _con_pool->getConnection();
-    if (connect == nullptr) {
-        return false;
+RedisPoolStats RedisMgr::GetPoolStats() const {
+    return _con_pool->GetStats();
+}
+
+std::shared_ptr<RedisAsyncConnection> RedisMgr::GetAsyncConnection(net::io_context& ioc) {
+    //ÿio_contextֻԼ߳УӰ̻߳棬Ͽ´ʹʱ
+    thread_local std::unordered_map<net::io_context*, std::shared_ptr<RedisAsyncConnection>> connections;
+    auto& connection = connections[&ioc];
+    if (!connection || !connection->IsConnected()) {
+        connection = std::make_shared<RedisAsyncConnection>(ioc, _host, _port, _pwd);
+        if (!connection->Connect()) {
+            connection.reset();
+        }
     }
-    auto reply = (redisReply*)redisCommand(connect, "GET %s", key.c_str());
-    if (reply == NULL) {
-        std::cout << "[ GET  " << key << " ] failed" << std::endl;
-        freeReplyObject(reply);
-        _con_pool->returnConnection(connect);
-        return false;
+    return connection;
+}
+
+void RedisMgr::AsyncCommand(net::io_context& ioc, std::vector<std::string> args, RedisCallback callback) {
+    net::dispatch(ioc, [this, &ioc, args = std::move(args), callback = std::move(callback)]() mutable {
+        auto connection = GetAsyncConnection(ioc);
+        if (connection == nullptr) {
+            callback(RedisValue());
+            return;
+        }
+        connection->Command(args, std::move(callback));
+    });
+}
+
+net::awaitable<RedisValue> RedisMgr::AsyncCommand(std::vector<std::string> args) {
+    auto executor = co_await net::this_coro::executor;
+    auto& ioc = static_cast<net::io_context&>(net::query(executor, net::execution::context));
+    co_return co_await net::async_initiate<decltype(net::use_awaitable), void(RedisValue)>(
+        [this, &ioc, args = std::move(args)](auto handler) mutable {
+            //use_awaitablehandlerֻƶstd::functionҪɿŽshared_ptr
+            auto shared = std::make_shared<decltype(handler)>(std::move(handler));
+            AsyncCommand(ioc, std::move(args), [shared](RedisValue value) {
+                (*shared)(std::move(value));
+            });
+        }, net::use_awaitable);
+}
+
+net::awaitable<bool> RedisMgr::AsyncGet(std::string_view key, std::string& value) {
+    std::vector<std::string> args{ "GET", std::string(key) };
+    auto reply = co_await AsyncCommand(std::move(args));
+    if (!reply.IsString()) {
+        std::cout << "[ ASYNC GET  " << key << " ] failed" << std::endl;
+        co_return false;
     }
+    value = std::move(reply.str);
+    co_return true;
+}
 
-    if (reply->type != REDIS_REPLY_STRING) {
-        std::cout << "[ GET  " << key << " ] failed" << std::endl;
-        freeReplyObject(reply);
-        _con_pool->returnConnection(connect);
-        return false;
+net::awaitable<bool> RedisMgr::AsyncSet(std::string_view key, std::string_view value) {
+    std::vector<std::string> args{ "SET", std::string(key), std::string(value) };
+    auto reply = co_await AsyncCommand(std::move(args));
+    if (!(reply.type == REDIS_REPLY_STATUS && (reply.str == "OK" || reply.str == "ok"))) {
+        std::cout << "Execut command [ ASYNC SET " << key << " ] failure ! " << std::endl;
+        co_return false;
     }
+    co_return true;
+}
 
-    value = reply->str;
-    freeReplyObject(reply);
+net::awaitable<bool> RedisMgr::AsyncDel(std::string_view key) {
+    std::vector<std::string> args{ "DEL", std::string(key) };
+    auto reply = co_await AsyncCommand(std::move(args));
+    if (!reply.IsInteger()) {
+        std::cout << "Execut command [ ASYNC DEL " << key << " ] failure ! " << std::endl;
+        co_return false;
+    }
+    co_return true;
+}
 
-    std::cout << "Succeed to execute command [ GET " << key << "  ]" << std::endl;
-    _con_pool->returnConnection(connect);
-    return true;
+net::awaitable<bool> RedisMgr::AsyncCheckAndDel(std::string_view key, std::string_view expected) {
+    RedisValue reply;
+    if (!_check_and_del.sha.empty()) {
+        std::vector<std::string> args{ "EVALSHA", _check_and_del.sha, "1", std::string(key), std::string(expected) };
+        reply = co_await AsyncCommand(std::move(args));
+    }
+    //ûsha˽ű汻ʱΪEVAL
+    if (_check_and_del.sha.empty() || (reply.type == REDIS_REPLY_ERROR && reply.str.rfind("NOSCRIPT", 0) == 0)) {
+        std::vector<std::string> args{ "EVAL", std::string(_check_and_del.source), "1", std::string(key), std::string(expected) };
+        reply = co_await AsyncCommand(std::move(args));
+    }
+    co_return reply.IsInteger() && reply.integer > 0;
 }
-bool RedisMgr::Set(const std::string& key, const std::string& value) {
+
+RedisReplyPtr RedisMgr::Execute(std::initializer_list<std::string_view> args)
+{
     auto connect = _con_pool->getConnection();
     if (connect == nullptr) {
-        return false;
+        return nullptr;
     }
+    //ֱӱRESPд뱾̸߳õĻ壬ʽưȫ
+    thread_local std::string buffer;
+    buffer.clear();
+    RespEncoder::AppendCommand(buffer, args);
+    void* reply = nullptr;
+    if (redisAppendFormattedCommand(connect, buffer.data(), buffer.size()) != REDIS_OK
+        || redisGetReply(connect, &reply) != REDIS_OK) {
+        reply = nullptr;
+    }
+    _con_pool->returnConnection(connect);
+    return RedisReplyPtr(static_cast<redisReply*>(reply));
+}
 
-    auto reply = (redisReply*)redisCommand(connect, "SET %s %s", key.c_str(), value.c_str());
-
-    //NULL˵ִʧ
-    if (NULL == reply)
-    {
-        std::cout << "Execut command [ SET " << key << "  " << value << " ] failure ! " << std::endl;
-        _con_pool->returnConnection(connect);
+bool RedisMgr::Get(std::string_view key, std::string& value)
+{
+    auto reply = Execute({ "GET", key });
+    if (reply == nullptr || reply->type != REDIS_REPLY_STRING) {
+        std::cout << "[ GET  " << key << " ] failed" << std::endl;
         return false;
     }
+    value.assign(reply->str, reply->len);
+    std::cout << "Succeed to execute command [ GET " << key << "  ]" << std::endl;
+    return true;
+}
 
-    //ִʧͷ
-    if (!(reply->type == REDIS_REPLY_STATUS && (strcmp(reply->str, "OK") == 0 || strcmp(reply->str, "ok") == 0)))
+bool RedisMgr::Set(std::string_view key, std::string_view value) {
+    auto reply = Execute({ "SET", key, value });
+    //NULL״̬OK˵ִʧ
+    if (reply == nullptr || !(reply->type == REDIS_REPLY_STATUS && (strcmp(reply->str, "OK") == 0 || strcmp(reply->str, "ok") == 0)))
     {
-        std::cout << "Execut command [ SET " << key << "  " << value << " ] failure ! " << std::endl;
-        freeReplyObject(reply);
-        _con_pool->returnConnection(connect);
+        std::cout << "Execut command [ SET " << key << " ] failure ! " << std::endl;
         return false;
     }
-
-    //ִгɹ ͷredisCommandִк󷵻صredisReplyռõڴ
-    freeReplyObject(reply);
-    std::cout << "Execut command [ SET " << key << "  " << value << " ] success ! " << std::endl;
-    _con_pool->returnConnection(connect);
+    std::cout << "Execut command [ SET " << key << " ] success ! " << std::endl;
     return true;
 }
 
-bool RedisMgr::Auth(const std::string& password)
+bool RedisMgr::Auth(std::string_view password)
 {
-    this->_reply = (redisReply*)redisCommand(this->_connect, "AUTH %s", password.c_str());
-    if (this->_reply->type == REDIS_REPLY_ERROR) {
+    auto reply = Execute({ "AUTH", password });
+    if (reply == nullptr || reply->type == REDIS_REPLY_ERROR) {
         std::cout << "֤ʧ" << std::endl;
-        //ִгɹ ͷredisCommandִк󷵻صredisReplyռõڴ
-        freeReplyObject(this->_reply);
         return false;
     }
-    else {
-        //ִгɹ ͷredisCommandִк󷵻صredisReplyռõڴ
-        freeReplyObject(this->_reply);
-        std::cout << "֤ɹ" << std::endl;
-        return true;
-    }
+    std::cout << "֤ɹ" << std::endl;
+    return true;
 }
 
-bool RedisMgr::LPush(const std::string& key, const std::string& value)
+bool RedisMgr::LPush(std::string_view key, std::string_view value)
 {
-    this->_reply = (redisReply*)redisCommand(this->_connect, "LPUSH %s %s", key.c_str(), value.c_str());
-    if (NULL == this->_reply)
-    {
-        std::cout << "Execut command [ LPUSH " << key << "  " << value << " ] failure ! " << std::endl;
-        freeReplyObject(this->_reply);
-        return false;
-    }
-
-    if (this->_reply->type != REDIS_REPLY_INTEGER || this->_reply->integer <= 0) {
-        std::cout << "Execut command [ LPUSH " << key << "  " << value << " ] failure ! " << std::endl;
-        freeReplyObject(this->_reply);
+    auto reply = Execute({ "LPUSH", key, value });
+    if (reply == nullptr || reply->type != REDIS_REPLY_INTEGER || reply->integer <= 0) {
+        std::cout << "Execut command [ LPUSH " << key << " ] failure ! " << std::endl;
         return false;
     }
-
-    std::cout << "Execut command [ LPUSH " << key << "  " << value << " ] success ! " << std::endl;
-    freeReplyObject(this->_reply);
+    std::cout << "Execut command [ LPUSH " << key << " ] success ! " << std::endl;
     return true;
 }
 
-bool RedisMgr::LPop(const std::string& key, std::string& value) {
-    this->_reply = (redisReply*)redisCommand(this->_connect, "LPOP %s ", key.c_str());
-    if (_reply == nullptr || _reply->type == REDIS_REPLY_NIL) {
+bool RedisMgr::LPop(std::string_view key, std::string& value) {
+    auto reply = Execute({ "LPOP", key });
+    if (reply == nullptr || reply->type != REDIS_REPLY_STRING) {
         std::cout << "Execut command [ LPOP " << key << " ] failure ! " << std::endl;
-        freeReplyObject(this->_reply);
         return false;
     }
-    value = _reply->str;
+    value.assign(reply->str, reply->len);
     std::cout << "Execut command [ LPOP " << key << " ] success ! " << std::endl;
-    freeReplyObject(this->_reply);
     return true;
 }
 
-bool RedisMgr::RPush(const std::string& key, const std::string& value) {
-    this->_reply = (redisReply*)redisCommand(this->_connect, "RPUSH %s %s", key.c_str(), value.c_str());
-    if (NULL == this->_reply)
-    {
-        std::cout << "Execut command [ RPUSH " << key << "  " << value << " ] failure ! " << std::endl;
-        freeReplyObject(this->_reply);
-        return false;
-    }
-
-    if (this->_reply->type != REDIS_REPLY_INTEGER || this->_reply->integer <= 0) {
-        std::cout << "Execut command [ RPUSH " << key << "  " << value << " ] failure ! " << std::endl;
-        freeReplyObject(this->_reply);
+bool RedisMgr::RPush(std::string_view key, std::string_view value) {
+    auto reply = Execute({ "RPUSH", key, value });
+    if (reply == nullptr || reply->type != REDIS_REPLY_INTEGER || reply->integer <= 0) {
+        std::cout << "Execut command [ RPUSH " << key << " ] failure ! " << std::endl;
         return false;
     }
-
-    std::cout << "Execut command [ RPUSH " << key << "  " << value << " ] success ! " << std::endl;
-    freeReplyObject(this->_reply);
+    std::cout << "Execut command [ RPUSH " << key << " ] success ! " << std::endl;
     return true;
 }
 
-bool RedisMgr::RPop(const std::string& key, std::string& value) {
-    this->_reply = (redisReply*)redisCommand(this->_connect, "RPOP %s ", key.c_str());
-    if (_reply == nullptr || _reply->type == REDIS_REPLY_NIL) {
+bool RedisMgr::RPop(std::string_view key, std::string& value) {
+    auto reply = Execute({ "RPOP", key });
+    if (reply == nullptr || reply->type != REDIS_REPLY_STRING) {
         std::cout << "Execut command [ RPOP " << key << " ] failure ! " << std::endl;
-        freeReplyObject(this->_reply);
         return false;
     }
-    value = _reply->str;
+    value.assign(reply->str, reply->len);
     std::cout << "Execut command [ RPOP " << key << " ] success ! " << std::endl;
-    freeReplyObject(this->_reply);
     return true;
 }
 
-
-bool RedisMgr::HSet(const std::string& key, const std::string& hkey, const std::string& value) {
-    this->_reply = (redisReply*)redisCommand(this->_connect, "HSET %s %s %s", key.c_str(), hkey.c_str(), value.c_str());
-    if (_reply == nullptr || _reply->type != REDIS_REPLY_INTEGER) {
-        std::cout << "Execut command [ HSet " << key << "  " << hkey << "  " << value << " ] failure ! " << std::endl;
-        freeReplyObject(this->_reply);
+bool RedisMgr::HSet(std::string_view key, std::string_view hkey, std::string_view value) {
+    auto reply = Execute({ "HSET", key, hkey, value });
+    if (reply == nullptr || reply->type != REDIS_REPLY_INTEGER) {
+        std::cout << "Execut command [ HSet " << key << "  " << hkey << " ] failure ! " << std::endl;
         return false;
     }
-    std::cout << "Execut command [ HSet " << key << "  " << hkey << "  " << value << " ] success ! " << std::endl;
-    freeReplyObject(this->_reply);
+    std::cout << "Execut command [ HSet " << key << "  " << hkey << " ] success ! " << std::endl;
     return true;
 }
 
-
 bool RedisMgr::HSet(const char* key, const char* hkey, const char* hvalue, size_t hvaluelen)
 {
-    const char* argv[4];
-    size_t argvlen[4];
-    argv[0] = "HSET";
-    argvlen[0] = 4;
-    argv[1] = key;
-    argvlen[1] = strlen(key);
-    argv[2] = hkey;
-    argvlen[2] = strlen(hkey);
-    argv[3] = hvalue;
-    argvlen[3] = hvaluelen;
-    this->_reply = (redisReply*)redisCommandArgv(this->_connect, 4, argv, argvlen);
-    if (_reply == nullptr || _reply->type != REDIS_REPLY_INTEGER) {
-        std::cout << "Execut command [ HSet " << key << "  " << hkey << "  " << hvalue << " ] failure ! " << std::endl;
-        freeReplyObject(this->_reply);
-        return false;
-    }
-    std::cout << "Execut command [ HSet " << key << "  " << hkey << "  " << hvalue << " ] success ! " << std::endl;
-    freeReplyObject(this->_reply);
-    return true;
+    return HSet(std::string_view(key), std::string_view(hkey), std::string_view(hvalue, hvaluelen));
 }
 
-
-std::string RedisMgr::HGet(const std::string& key, const std::string& hkey)
+std::string RedisMgr::HGet(std::string_view key, std::string_view hkey)
 {
-    const char* argv[3];
-    size_t argvlen[3];
-    argv[0] = "HGET";
-    argvlen[0] = 4;
-    argv[1] = key.c_str();
-    argvlen[1] = key.length();
-    argv[2] = hkey.c_str();
-    argvlen[2] = hkey.length();
-    this->_reply = (redisReply*)redisCommandArgv(this->_connect, 3, argv, argvlen);
-    if (this->_reply == nullptr || this->_reply->type == REDIS_REPLY_NIL) {
-        freeReplyObject(this->_reply);
+    auto reply = Execute({ "HGET", key, hkey });
+    if (reply == nullptr || reply->type != REDIS_REPLY_STRING) {
         std::cout << "Execut command [ HGet " << key << " " << hkey << "  ] failure ! " << std::endl;
         return "";
     }
-
-    std::string value = this->_reply->str;
-    freeReplyObject(this->_reply);
     std::cout << "Execut command [ HGet " << key << " " << hkey << " ] success ! " << std::endl;
-    return value;
+    return std::string(reply->str, reply->len);
 }
 
-
-bool RedisMgr::Del(const std::string& key)
+bool RedisMgr::Del(std::string_view key)
 {
-    auto connect = _con_pool->getConnection();
-    if (connect == nullptr) {
-        return false;
-    }
-    
-    auto reply = (redisReply*)redisCommand(connect, "DEL %s", key.c_str());
+    auto reply = Execute({ "DEL", key });
     if (reply == nullptr || reply->type != REDIS_REPLY_INTEGER) {
         std::cout << "Execut command [ Del " << key << " ] failure ! " << std::endl;
-        freeReplyObject(reply);
-        _con_pool->returnConnection(connect);
         return false;
     }
     std::cout << "Execut command [ Del " << key << " ] success ! " << std::endl;
-    freeReplyObject(reply);
-    _con_pool->returnConnection(connect);
     return true;
 }
 
-bool RedisMgr::ExistsKey(const std::string& key)
+bool RedisMgr::ExistsKey(std::string_view key)
 {
-    this->_reply = (redisReply*)redisCommand(this->_connect, "exists %s", key.c_str());
-    if (this->_reply == nullptr || this->_reply->type != REDIS_REPLY_INTEGER || this->_reply->integer == 0) {
+    auto reply = Execute({ "EXISTS", key });
+    if (reply == nullptr || reply->type != REDIS_REPLY_INTEGER || reply->integer == 0) {
         std::cout << "Not Found [ Key " << key << " ]  ! " << std::endl;
-        freeReplyObject(this->_reply);
         return false;
     }
     std::cout << " Found [ Key " << key << " ] exists ! " << std::endl;
-    freeReplyObject(this->_reply);
     return true;
-}
\ No newline at end of file
+}
+
+bool RedisMgr::ReadReplies(redisContext* connect, size_t count, std::vector<RedisValue>& replies) {
+    replies.clear();
+    replies.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        void* reply = nullptr;
+        //һεʱһд
+        if (redisGetReply(connect, &reply) != REDIS_OK) {
+            std::cout << "Execut pipeline failure: " << connect->errstr << std::endl;
+            return false;
+        }
+        replies.push_back(RedisValue::FromReply(static_cast<redisReply*>(reply)));
+        freeReplyObject(reply);
+    }
+    return true;
+}
+
+bool RedisMgr::Exec(const RedisBatch& batch, std::vector<RedisValue>& replies) {
+    if (batch.Empty()) {
+        replies.clear();
+        return true;
+    }
+    auto connect = _con_pool->getConnection();
+    if (connect == nullptr) {
+        return false;
+    }
+    bool ok = batch.AppendTo(connect) && ReadReplies(connect, batch.Size(), replies);
+    _con_pool->returnConnection(connect);
+    return ok;
+}
+
+bool RedisMgr::ExecTransaction(const RedisBatch& batch, std::vector<RedisValue>& replies) {
+    auto connect = _con_pool->getConnection();
+    if (connect == nullptr) {
+        return false;
+    }
+    const char* multi = "MULTI";
+    const char* exec = "EXEC";
+    bool ok = redisAppendCommandArgv(connect, 1, &multi, nullptr) == REDIS_OK
+        && batch.AppendTo(connect)
+        && redisAppendCommandArgv(connect, 1, &exec, nullptr) == REDIS_OK;
+    //MULTIÿQUEUEDӦ֮EXECĽ
+    std::vector<RedisValue> all;
+    ok = ok && ReadReplies(connect, batch.Size() + 2, all);
+    _con_pool->returnConnection(connect);
+    if (!ok || all.back().type != REDIS_REPLY_ARRAY) {
+        std::cout << "Execut transaction failure ! " << std::endl;
+        return false;
+    }
+    replies = std::move(all.back().elements);
+    return true;
+}
+
+std::string RedisMgr::LoadScript(std::string_view source) {
+    auto value = RedisValue::FromReply(Execute({ "SCRIPT", "LOAD", source }).get());
+    if (!value.IsString()) {
+        std::cout << "Execut command [ SCRIPT LOAD ] failure ! " << std::endl;
+        return std::string();
+    }
+    return value.str;
+}
+
+RedisValue RedisMgr::EvalScript(const RedisScript& script, std::initializer_list<std::string_view> keys,
+    std::initializer_list<std::string_view> args) {
+    auto numkeys = std::to_string(keys.size());
+    RedisBatch batch;
+    auto eval = [&](std::string_view command, std::string_view body) {
+        std::vector<std::string> argv;
+        argv.reserve(3 + keys.size() + args.size());
+        argv.emplace_back(command);
+        argv.emplace_back(body);
+        argv.push_back(numkeys);
+        argv.insert(argv.end(), keys.begin(), keys.end());
+        argv.insert(argv.end(), args.begin(), args.end());
+        batch.Clear();
+        batch.Add(argv);
+        std::vector<RedisValue> replies;
+        if (!Exec(batch, replies)) {
+            return RedisValue();
+        }
+        return std::move(replies.front());
+    };
+
+    if (!script.sha.empty()) {
+        auto value = eval("EVALSHA", script.sha);
+        //˽ű汻(SCRIPT FLUSH)ʱΪEVALEVAL»ű
+        if (!(value.type == REDIS_REPLY_ERROR && value.str.rfind("NOSCRIPT", 0) == 0)) {
+            return value;
+        }
+    }
+    return eval("EVAL", script.source);
+}
+
+bool RedisMgr::CheckAndDel(std::string_view key, std::string_view expected) {
+    auto value = EvalScript(_check_and_del, { key }, { expected });
+    return value.IsInteger() && value.integer > 0;
+}
@@ -2,31 +2,67 @@
 #include "const.h"
 #include "Singleton.h"
 #include "RedisConPool.h"
+#include "RedisAsyncConnection.h"
+#include "RedisBatch.h"
 #include <memory>
 
+//Lua脚本，sha在第一次SCRIPT LOAD后记录，EVALSHA遇到NOSCRIPT时回退为EVAL
+struct RedisScript {
+    std::string_view source;
+    std::string sha;
+};
+
 class RedisMgr : public Singleton<RedisMgr>
 {
 	friend class Singleton<RedisMgr>;
 public:
 	~RedisMgr();
-    bool Connect(const std::string& host, int port);
-    bool Get(const std::string& key, std::string& value);
-    bool Set(const std::string& key, const std::string& value);
-    bool Auth(const std::string& password);
-    bool LPush(const std::string& key, const std::string& value);
-    bool LPop(const std::string& key, std::string& value);
-    bool RPush(const std::string& key, const std::string& value);
-    bool RPop(const std::string& key, std::string& value);
-    bool HSet(const std::string& key, const std::string& hkey, const std::string& value);
+    //所有命令都按RESP直接编码，key/value二进制安全
+    bool Get(std::string_view key, std::string& value);
+    bool Set(std::string_view key, std::string_view value);
+    bool Auth(std::string_view password);
+    bool LPush(std::string_view key, std::string_view value);
+    bool LPop(std::string_view key, std::string& value);
+    bool RPush(std::string_view key, std::string_view value);
+    bool RPop(std::string_view key, std::string& value);
+    bool HSet(std::string_view key, std::string_view hkey, std::string_view value);
     bool HSet(const char* key, const char* hkey, const char* hvalue, size_t hvaluelen);
-    std::string HGet(const std::string& key, const std::string& hkey);
-    bool Del(const std::string& key);
-    bool ExistsKey(const std::string& key);
+    std::string HGet(std::string_view key, std::string_view hkey);
+    bool Del(std::string_view key);
+    bool ExistsKey(std::string_view key);
     void Close();
+    RedisPoolStats GetPoolStats() const;
+
+    //流水线执行：所有命令一次写出，按顺序返回每条命令的应答
+    bool Exec(const RedisBatch& batch, std::vector<RedisValue>& replies);
+    //MULTI/EXEC事务执行，replies为EXEC返回的各条命令应答
+    bool ExecTransaction(const RedisBatch& batch, std::vector<RedisValue>& replies);
+    RedisValue EvalScript(const RedisScript& script, std::initializer_list<std::string_view> keys,
+        std::initializer_list<std::string_view> args);
+    //key的值等于expected时原子地删除它，返回是否删除
+    bool CheckAndDel(std::string_view key, std::string_view expected);
+    //SCRIPT LOAD，返回脚本的sha；失败返回空串，EvalScript此时直接用EVAL
+    std::string LoadScript(std::string_view source);
+
+    //异步接口：命令经由ioc上的redisAsyncContext发送，不占用连接池，
+    //callback在ioc线程上执行
+    void AsyncCommand(net::io_context& ioc, std::vector<std::string> args, RedisCallback callback);
+    //协程版本，使用当前协程所在的io_context
+    net::awaitable<RedisValue> AsyncCommand(std::vector<std::string> args);
+    net::awaitable<bool> AsyncGet(std::string_view key, std::string& value);
+    net::awaitable<bool> AsyncSet(std::string_view key, std::string_view value);
+    net::awaitable<bool> AsyncDel(std::string_view key);
+    //CheckAndDel的协程版本
+    net::awaitable<bool> AsyncCheckAndDel(std::string_view key, std::string_view expected);
 private:
 	RedisMgr();
-    redisContext* _connect;
-    redisReply* _reply;
+    std::shared_ptr<RedisAsyncConnection> GetAsyncConnection(net::io_context& ioc);
+    RedisReplyPtr Execute(std::initializer_list<std::string_view> args);
+    bool ReadReplies(redisContext* connect, size_t count, std::vector<RedisValue>& replies);
     std::unique_ptr<RedisConPool> _con_pool;
+    std::string _host;
+    int _port;
+    std::string _pwd;
+    RedisScript _check_and_del;
 };
 
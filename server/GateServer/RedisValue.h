@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include<hiredis.h>
+
+//与redisReply对应的值类型，reply释放后仍可安全使用。
+//type为0表示命令没有拿到应答(连接失败、连接断开等)。
+struct RedisValue {
+    int type = 0;
+    long long integer = 0;
+    std::string str;
+    std::vector<RedisValue> elements;
+
+    bool IsOk() const { return type != 0 && type != REDIS_REPLY_ERROR; }
+    bool IsNil() const { return type == REDIS_REPLY_NIL; }
+    bool IsString() const { return type == REDIS_REPLY_STRING; }
+    bool IsInteger() const { return type == REDIS_REPLY_INTEGER; }
+
+    static RedisValue FromReply(const redisReply* reply) {
+        RedisValue value;
+        if (reply == nullptr) {
+            return value;
+        }
+        value.type = reply->type;
+        switch (reply->type) {
+        case REDIS_REPLY_INTEGER:
+            value.integer = reply->integer;
+            break;
+        case REDIS_REPLY_STRING:
+        case REDIS_REPLY_STATUS:
+        case REDIS_REPLY_ERROR:
+            value.str.assign(reply->str, reply->len);
+            break;
+        case REDIS_REPLY_ARRAY:
+            value.elements.reserve(reply->elements);
+            for (size_t i = 0; i < reply->elements; ++i) {
+                value.elements.push_back(FromReply(reply->element[i]));
+            }
+            break;
+        default:
+            break;
+        }
+        return value;
+    }
+};
+
+struct RedisReplyDeleter {
+    void operator()(redisReply* reply) const { freeReplyObject(reply); }
+};
+typedef std::unique_ptr<redisReply, RedisReplyDeleter> RedisReplyPtr;
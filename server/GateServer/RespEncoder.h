@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <initializer_list>
+#include <charconv>
+
+//把命令参数直接编码成RESP协议格式追加到out中，不解析格式串；
+//参数按长度写入，二进制安全，值里可以有空格、\0或任意protobuf字节。
+//out可以跨调用复用，clear后保留容量，稳定后不再分配内存。
+class RespEncoder {
+public:
+    static void AppendCommand(std::string& out, std::initializer_list<std::string_view> args) {
+        AppendRange(out, args);
+    }
+
+    template<typename Range>
+    static void AppendRange(std::string& out, const Range& args) {
+        AppendHeader(out, '*', std::size(args));
+        for (auto& arg : args) {
+            AppendHeader(out, '$', std::size(arg));
+            out.append(std::data(arg), std::size(arg));
+            out.append("\r\n", 2);
+        }
+    }
+
+private:
+    static void AppendHeader(std::string& out, char prefix, size_t n) {
+        char buf[24];
+        buf[0] = prefix;
+        auto end = std::to_chars(buf + 1, buf + sizeof(buf) - 2, n).ptr;
+        *end++ = '\r';
+        *end++ = '\n';
+        out.append(buf, end - buf);
+    }
+};
@@ -0,0 +1,98 @@
+#include "RouteTable.h"
+
+namespace {
+	//依次取出路径中的下一段，跳过多余的'/'
+	bool NextSegment(std::string_view& path, std::string_view& segment) {
+		while (!path.empty() && path.front() == '/') {
+			path.remove_prefix(1);
+		}
+		if (path.empty()) {
+			return false;
+		}
+		auto pos = path.find('/');
+		segment = path.substr(0, pos);
+		path.remove_prefix(pos == std::string_view::npos ? path.size() : pos);
+		return true;
+	}
+}
+
+std::size_t RouteTable::CountSegments(std::string_view path) {
+	std::size_t count = 0;
+	std::string_view segment;
+	while (NextSegment(path, segment)) {
+		++count;
+	}
+	return count;
+}
+
+std::uint64_t RouteTable::BucketKey(http::verb method, std::size_t segmentCount) {
+	return (static_cast<std::uint64_t>(method) << 32) | segmentCount;
+}
+
+RouteHandler& RouteTable::Add(http::verb method, std::string_view pattern) {
+	if (pattern.find('{') == std::string_view::npos) {
+		return _static_routes[RouteKey{ method, std::string(pattern) }];
+	}
+
+	PatternRoute route;
+	std::string_view rest = pattern;
+	std::string_view segment;
+	while (NextSegment(rest, segment)) {
+		bool isParam = segment.size() >= 2 && segment.front() == '{' && segment.back() == '}';
+		if (isParam) {
+			segment = segment.substr(1, segment.size() - 2);
+		}
+		route.segments.push_back(Segment{ std::string(segment), isParam });
+	}
+
+	auto& bucket = _pattern_routes[BucketKey(method, route.segments.size())];
+	for (auto& existing : bucket) {
+		bool same = true;
+		for (std::size_t i = 0; i < existing.segments.size() && same; ++i) {
+			same = existing.segments[i].isParam == route.segments[i].isParam &&
+				existing.segments[i].text == route.segments[i].text;
+		}
+		if (same) {
+			return existing.handler;
+		}
+	}
+	bucket.push_back(std::move(route));
+	return bucket.back().handler;
+}
+
+RouteHandler* RouteTable::Find(http::verb method, std::string_view path, UrlParams& params) {
+	auto iter = _static_routes.find(RouteKeyView{ method, path });
+	if (iter != _static_routes.end()) {
+		return &iter->second;
+	}
+
+	if (_pattern_routes.empty()) {
+		return nullptr;
+	}
+	auto bucket = _pattern_routes.find(BucketKey(method, CountSegments(path)));
+	if (bucket == _pattern_routes.end()) {
+		return nullptr;
+	}
+
+	for (auto& route : bucket->second) {
+		params.clear();
+		std::string_view rest = path;
+		std::string_view segment;
+		bool matched = true;
+		for (auto& expected : route.segments) {
+			NextSegment(rest, segment);
+			if (expected.isParam) {
+				params.emplace_back(expected.text, segment);
+			}
+			else if (expected.text != segment) {
+				matched = false;
+				break;
+			}
+		}
+		if (matched) {
+			return &route.handler;
+		}
+	}
+	params.clear();
+	return nullptr;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "const.h"
+#include <string_view>
+
+class HttpConnection;
+typedef std::function<void(std::shared_ptr<HttpConnection>)> HttpHandler;
+//协程版handler，阻塞的数据库调用交给DBExecutor，不占用io_context线程。
+//注册时需显式包装成AsyncHttpHandler，以便和同步handler区分。
+typedef std::function<net::awaitable<void>(std::shared_ptr<HttpConnection>)> AsyncHttpHandler;
+
+struct RouteHandler {
+    HttpHandler handler;
+    AsyncHttpHandler asyncHandler;
+};
+
+//路径参数/查询参数，直接引用请求target中的字符，不做拷贝，只在当前请求内有效。
+typedef std::vector<std::pair<std::string_view, std::string_view>> UrlParams;
+
+//路由表：方法+路径一次哈希查找命中静态路由；
+//带 {name} 段的路由(如 /user/{id})预先切分成段，按 方法+段数 分桶匹配。
+//查找全程使用string_view，不产生内存分配。
+class RouteTable
+{
+public:
+    RouteHandler& Add(http::verb method, std::string_view pattern);
+    //未命中返回nullptr；命中参数路由时把参数写入params
+    RouteHandler* Find(http::verb method, std::string_view path, UrlParams& params);
+
+private:
+    struct RouteKey {
+        http::verb method;
+        std::string path;
+    };
+    struct RouteKeyView {
+        http::verb method;
+        std::string_view path;
+    };
+    struct RouteKeyHash {
+        using is_transparent = void;
+        std::size_t operator()(const RouteKey& key) const { return Hash(key.method, key.path); }
+        std::size_t operator()(const RouteKeyView& key) const { return Hash(key.method, key.path); }
+        static std::size_t Hash(http::verb method, std::string_view path) {
+            return std::hash<std::string_view>()(path) ^ (static_cast<std::size_t>(method) * 0x9e3779b97f4a7c15ULL);
+        }
+    };
+    struct RouteKeyEqual {
+        using is_transparent = void;
+        template <typename L, typename R>
+        bool operator()(const L& lhs, const R& rhs) const {
+            return lhs.method == rhs.method && std::string_view(lhs.path) == std::string_view(rhs.path);
+        }
+    };
+
+    struct Segment {
+        std::string text;
+        bool isParam;
+    };
+    struct PatternRoute {
+        std::vector<Segment> segments;
+        RouteHandler handler;
+    };
+
+    static std::size_t CountSegments(std::string_view path);
+    static std::uint64_t BucketKey(http::verb method, std::size_t segmentCount);
+
+    std::unordered_map<RouteKey, RouteHandler, RouteKeyHash, RouteKeyEqual> _static_routes;
+    std::unordered_map<std::uint64_t, std::vector<PatternRoute>> _pattern_routes;
+};
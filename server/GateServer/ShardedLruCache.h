@@ -0,0 +1,100 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+//分片LRU缓存，每个分片独立加锁，不同key的并发访问大多落在不同分片上。
+//条目带过期时间，过期的条目在访问时被淘汰。
+template <typename Key, typename Value>
+class ShardedLruCache
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    ShardedLruCache(std::size_t shardCount, std::size_t capacity, std::chrono::seconds ttl)
+        : _ttl(ttl) {
+        if (shardCount == 0) {
+            shardCount = 1;
+        }
+        std::size_t perShard = capacity / shardCount;
+        if (perShard == 0) {
+            perShard = 1;
+        }
+        for (std::size_t i = 0; i < shardCount; ++i) {
+            _shards.push_back(std::make_unique<Shard>(perShard));
+        }
+    }
+
+    bool Get(const Key& key, Value& out) {
+        auto& shard = ShardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            return false;
+        }
+        if (it->second->expire <= Clock::now()) {
+            shard.entries.erase(it->second);
+            shard.index.erase(it);
+            return false;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        out = it->second->value;
+        return true;
+    }
+
+    void Put(const Key& key, Value value) {
+        auto& shard = ShardFor(key);
+        auto expire = Clock::now() + _ttl;
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            it->second->value = std::move(value);
+            it->second->expire = expire;
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return;
+        }
+        shard.entries.push_front(Entry{ key, std::move(value), expire });
+        shard.index.emplace(key, shard.entries.begin());
+        if (shard.entries.size() > shard.capacity) {
+            shard.index.erase(shard.entries.back().key);
+            shard.entries.pop_back();
+        }
+    }
+
+    void Erase(const Key& key) {
+        auto& shard = ShardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.entries.erase(it->second);
+            shard.index.erase(it);
+        }
+    }
+
+private:
+    struct Entry {
+        Key key;
+        Value value;
+        Clock::time_point expire;
+    };
+
+    struct Shard {
+        explicit Shard(std::size_t cap) : capacity(cap) {}
+        std::mutex mutex;
+        std::list<Entry> entries;
+        std::unordered_map<Key, typename std::list<Entry>::iterator> index;
+        std::size_t capacity;
+    };
+
+    Shard& ShardFor(const Key& key) {
+        return *_shards[std::hash<Key>()(key) % _shards.size()];
+    }
+
+    std::vector<std::unique_ptr<Shard>> _shards;
+    std::chrono::seconds _ttl;
+};
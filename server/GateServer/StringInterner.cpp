@@ -0,0 +1,58 @@
+#include "StringInterner.h"
+
+InternedString::InternedString(std::string_view value)
+    : _value(value.empty() ? nullptr : StringInterner::Instance().Intern(value)) {
+}
+
+const std::string& InternedString::Empty() {
+    static const std::string empty;
+    return empty;
+}
+
+StringInterner& StringInterner::Instance() {
+    //故意不析构：静态对象(比如缓存单例)里的驻留字符串可能在退出时才释放，那时驻留池必须还在
+    static StringInterner* instance = new StringInterner();
+    return *instance;
+}
+
+std::shared_ptr<const std::string> StringInterner::Intern(std::string_view value) {
+    auto& shard = ShardFor(value);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(value);
+    if (it != shard.entries.end()) {
+        if (auto existing = it->second.lock()) {
+            return existing;
+        }
+        //最后一个引用刚释放，Release还没拿到锁；换成新副本，旧条目由这里删除
+        shard.entries.erase(it);
+    }
+
+    auto copy = new std::string(value);
+    std::shared_ptr<const std::string> interned(copy, [this](const std::string* released) {
+        Release(released);
+    });
+    shard.entries.emplace(std::string_view(*copy), interned);
+    return interned;
+}
+
+void StringInterner::Release(const std::string* value) {
+    {
+        auto& shard = ShardFor(*value);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(*value);
+        //条目可能已经换成重新驻留的新副本，只删除指向自己的
+        if (it != shard.entries.end() && it->first.data() == value->data()) {
+            shard.entries.erase(it);
+        }
+    }
+    delete value;
+}
+
+std::size_t StringInterner::Size() {
+    std::size_t size = 0;
+    for (auto& shard : _shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size += shard.entries.size();
+    }
+    return size;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+//驻留字符串：内容相同的字符串在进程内只保存一份，对象本身只是指向共享副本的指针，
+//复制不分配内存也不复制内容。最后一个引用释放时副本从驻留池中删除。
+//适合重复度高的字段，比如大量用户共用的默认头像。空字符串不进驻留池。
+class InternedString
+{
+public:
+    InternedString() = default;
+    InternedString(std::string_view value);
+    InternedString(const std::string& value) : InternedString(std::string_view(value)) {}
+    InternedString(const char* value) : InternedString(std::string_view(value)) {}
+
+    const std::string& str() const {
+        return _value ? *_value : Empty();
+    }
+
+    operator std::string_view() const {
+        return str();
+    }
+
+    bool empty() const {
+        return !_value;
+    }
+
+    //内容相同的驻留字符串通常指向同一个副本，比较指针即可
+    bool operator==(const InternedString& other) const {
+        return _value == other._value || str() == other.str();
+    }
+
+private:
+    static const std::string& Empty();
+
+    std::shared_ptr<const std::string> _value;
+};
+
+//驻留池，按内容哈希分片加锁
+class StringInterner
+{
+public:
+    static StringInterner& Instance();
+
+    std::shared_ptr<const std::string> Intern(std::string_view value);
+
+    //当前驻留的不同字符串个数
+    std::size_t Size();
+
+private:
+    static constexpr std::size_t SHARD_COUNT = 16;
+
+    struct Shard {
+        std::mutex mutex;
+        //key指向value所指的副本，副本释放前条目一定已被删除
+        std::unordered_map<std::string_view, std::weak_ptr<const std::string>> entries;
+    };
+
+    StringInterner() = default;
+
+    Shard& ShardFor(std::string_view value) {
+        return _shards[std::hash<std::string_view>()(value) % SHARD_COUNT];
+    }
+
+    //最后一个引用释放时调用
+    void Release(const std::string* value);
+
+    Shard _shards[SHARD_COUNT];
+};
@@ -1,3 +1,343 @@
 #include "VarifyGrpcClient.h"
 #include"ConfigMgr.h"
+#include <algorithm>
+#include <sstream>
+#include <tuple>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
 
+namespace {
+    int readConfig(const char* key, int defaultValue) {
+        auto value = ConfigMgr::Inst()[VARIFY_CONFIG_SECTION][key];
+        int result = value.empty() ? 0 : atoi(value.c_str());
+        return result > 0 ? result : defaultValue;
+    }
+
+    std::string NewRequestId() {
+        thread_local boost::uuids::random_generator generator;
+        return boost::uuids::to_string(generator());
+    }
+}
+
+//一次调用可能发出多个请求(重试、对冲)，它们共用同一个请求体和截止时间。
+//请求的完成回调在gRPC自己的线程上执行，对冲定时器在发起调用的executor上执行，状态用mutex_保护；
+//第一个成功的应答或所有请求都失败后的最后一个错误作为结果，投递回executor交给调用方。
+class VerifyGrpcClient::Call : public std::enable_shared_from_this<VerifyGrpcClient::Call>
+{
+public:
+    typedef std::function<void(GetVarifyRsp)> Handler;
+
+    Call(VerifyGrpcClient* client, std::string email, std::chrono::steady_clock::time_point deadline,
+         net::any_io_executor executor, Handler handler)
+        : client_(client), deadline_(deadline), executor_(executor), hedgeTimer_(executor),
+          handler_(std::move(handler)) {
+        request_.set_email(std::move(email));
+        requestId_ = NewRequestId();
+        //gRPC的截止时间用system_clock表示，按剩余时间换算
+        grpcDeadline_ = std::chrono::system_clock::now() + (deadline - std::chrono::steady_clock::now());
+    }
+
+    void Start() {
+        std::shared_ptr<Attempt> attempt;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            attempt = NewAttemptLocked();
+        }
+        Send(attempt);
+
+        if (client_->hedgeDelay_.count() > 0 && client_->endpoints_.size() > 1) {
+            hedgeTimer_.expires_after(client_->hedgeDelay_);
+            hedgeTimer_.async_wait([self = shared_from_this()](boost::system::error_code ec) {
+                if (!ec) {
+                    self->OnHedgeTimer();
+                }
+            });
+        }
+    }
+
+private:
+    struct Attempt {
+        ClientContext context;
+        GetVarifyRsp reply;
+        Endpoint* endpoint = nullptr;
+    };
+
+    //还能否再发一个请求
+    bool CanSendLocked() const {
+        return static_cast<int>(attempts_.size()) < client_->maxAttempts_
+            && std::chrono::steady_clock::now() < deadline_;
+    }
+
+    std::shared_ptr<Attempt> NewAttemptLocked() {
+        auto attempt = std::make_shared<Attempt>();
+        attempt->context.set_deadline(grpcDeadline_);
+        attempt->context.AddMetadata(VARIFY_REQUEST_ID_METADATA, requestId_);
+        //重试和对冲请求尽量发给本次调用还没用过的实例
+        std::vector<Endpoint*> tried;
+        for (auto& previous : attempts_) {
+            tried.push_back(previous->endpoint);
+        }
+        attempt->endpoint = client_->PickEndpoint(tried);
+        attempts_.push_back(attempt);
+        ++running_;
+        return attempt;
+    }
+
+    //发请求时不持有mutex_，回调可能在当前线程上直接执行
+    void Send(const std::shared_ptr<Attempt>& attempt) {
+        attempt->endpoint->outstanding.fetch_add(1, std::memory_order_relaxed);
+        attempt->endpoint->stub->async()->GetVarifyCode(&attempt->context, &request_, &attempt->reply,
+            [self = shared_from_this(), attempt](Status status) {
+                attempt->endpoint->outstanding.fetch_sub(1, std::memory_order_relaxed);
+                self->client_->ReportResult(*attempt->endpoint, status);
+                self->OnAttemptDone(attempt, std::move(status));
+            });
+    }
+
+    void OnAttemptDone(const std::shared_ptr<Attempt>& attempt, Status status) {
+        std::shared_ptr<Attempt> retry;
+        bool done = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --running_;
+            if (finished_) {
+                return;
+            }
+            if (status.ok()) {
+                finished_ = done = true;
+            }
+            else {
+                lastError_ = status;
+                //UNAVAILABLE说明请求没有送达实例，换一个实例重试；其他错误(包括超过截止时间)不重试
+                if (status.error_code() == grpc::StatusCode::UNAVAILABLE && CanSendLocked()) {
+                    if (client_->budget_.TryWithdraw()) {
+                        client_->retries_.fetch_add(1, std::memory_order_relaxed);
+                        retry = NewAttemptLocked();
+                    }
+                    else {
+                        client_->budgetExhausted_.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+                if (!retry && running_ == 0) {
+                    finished_ = done = true;
+                }
+            }
+        }
+
+        if (retry) {
+            Send(retry);
+        }
+        else if (done) {
+            Finish(status.ok() ? std::move(attempt->reply) : GetVarifyRsp(), status);
+        }
+    }
+
+    void OnHedgeTimer() {
+        std::shared_ptr<Attempt> hedge;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (finished_ || !CanSendLocked()) {
+                return;
+            }
+            if (!client_->budget_.TryWithdraw()) {
+                client_->budgetExhausted_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            client_->hedges_.fetch_add(1, std::memory_order_relaxed);
+            hedge = NewAttemptLocked();
+        }
+        Send(hedge);
+    }
+
+    //finished_置位后调用，只会执行一次
+    void Finish(GetVarifyRsp reply, Status status) {
+        //其余还没完成的请求已经没有用了
+        std::vector<std::shared_ptr<Attempt>> attempts;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            attempts = attempts_;
+        }
+        for (auto& attempt : attempts) {
+            attempt->context.TryCancel();
+        }
+
+        net::post(executor_, [self = shared_from_this(), reply = std::move(reply), status = std::move(status)]() mutable {
+            self->hedgeTimer_.cancel();
+            if (!status.ok()) {
+                self->client_->failures_.fetch_add(1, std::memory_order_relaxed);
+                std::cout << "GetVarifyCode failed: " << status.error_message() << std::endl;
+                reply.set_error(ErrorCodes::RPCFailed);
+            }
+            self->handler_(std::move(reply));
+        });
+    }
+
+    VerifyGrpcClient* client_;
+    GetVarifyReq request_;
+    std::string requestId_;
+    std::chrono::steady_clock::time_point deadline_;
+    std::chrono::system_clock::time_point grpcDeadline_;
+    net::any_io_executor executor_;
+    net::steady_timer hedgeTimer_;
+    Handler handler_;
+
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<Attempt>> attempts_;
+    int running_ = 0;
+    bool finished_ = false;
+    Status lastError_;
+};
+
+RetryBudget::RetryBudget(int percent, int minPerSecond)
+    : balance_(minPerSecond), ratio_(percent / 100.0), minPerSecond_(minPerSecond),
+      lastRefill_(std::chrono::steady_clock::now()) {
+}
+
+void RetryBudget::Deposit() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    balance_ = std::min(balance_ + ratio_, static_cast<double>(VARIFY_RETRY_BUDGET_CAP));
+}
+
+bool RetryBudget::TryWithdraw() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - lastRefill_;
+    lastRefill_ = now;
+    balance_ = std::min(balance_ + elapsed.count() * minPerSecond_, static_cast<double>(VARIFY_RETRY_BUDGET_CAP));
+    if (balance_ < 1.0) {
+        return false;
+    }
+    balance_ -= 1.0;
+    return true;
+}
+
+VerifyGrpcClient::VerifyGrpcClient()
+    : timeout_(readConfig(VARIFY_TIMEOUT_KEY, VARIFY_DEFAULT_TIMEOUT_MS)),
+      hedgeDelay_(readConfig(VARIFY_HEDGE_DELAY_KEY, VARIFY_DEFAULT_HEDGE_DELAY_MS)),
+      maxAttempts_(readConfig(VARIFY_MAX_ATTEMPTS_KEY, VARIFY_DEFAULT_MAX_ATTEMPTS)),
+      budget_(readConfig(VARIFY_RETRY_BUDGET_PERCENT_KEY, VARIFY_DEFAULT_RETRY_BUDGET_PERCENT),
+              readConfig(VARIFY_RETRY_MIN_PER_SECOND_KEY, VARIFY_DEFAULT_RETRY_MIN_PER_SECOND)),
+      ejectFailures_(readConfig(VARIFY_EJECT_FAILURES_KEY, VARIFY_DEFAULT_EJECT_FAILURES)),
+      ejectTime_(readConfig(VARIFY_EJECT_TIME_KEY, VARIFY_DEFAULT_EJECT_TIME_MS)) {
+    auto section = ConfigMgr::Inst()[VARIFY_CONFIG_SECTION];
+    std::vector<std::string> targets;
+    std::stringstream ss(section[VARIFY_ENDPOINTS_KEY]);
+    std::string target;
+    while (std::getline(ss, target, ',')) {
+        target.erase(0, target.find_first_not_of(" \t"));
+        target.erase(target.find_last_not_of(" \t") + 1);
+        if (!target.empty()) {
+            targets.push_back(target);
+        }
+    }
+    //没有配置Endpoints时沿用Host/Port
+    if (targets.empty()) {
+        targets.push_back(section[VARIFY_HOST_KEY] + ":" + section[VARIFY_PORT_KEY]);
+    }
+
+    //每个实例一个通道，HTTP/2多路复用已经足够，同一实例的多个通道不会增加处理能力
+    for (auto& address : targets) {
+        auto endpoint = std::make_unique<Endpoint>();
+        endpoint->target = address;
+        endpoint->stub = VarifyService::NewStub(grpc::CreateChannel(address, grpc::InsecureChannelCredentials()));
+        endpoints_.push_back(std::move(endpoint));
+    }
+}
+
+VerifyGrpcClient::Endpoint* VerifyGrpcClient::PickEndpoint(const std::vector<Endpoint*>& tried) {
+    int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+    //从轮转的位置开始比较，未完成请求数相同时请求分散到各个实例
+    size_t start = next_.fetch_add(1, std::memory_order_relaxed);
+    Endpoint* best = nullptr;
+    std::tuple<bool, bool, int> bestRank;
+    for (size_t i = 0; i < endpoints_.size(); ++i) {
+        Endpoint* endpoint = endpoints_[(start + i) % endpoints_.size()].get();
+        bool used = std::find(tried.begin(), tried.end(), endpoint) != tried.end();
+        bool ejected = endpoint->ejectedUntil.load(std::memory_order_relaxed) > now;
+        //被摘除的实例排在最后，宁可把重试发回已经用过的健康实例
+        auto rank = std::make_tuple(ejected, used, endpoint->outstanding.load(std::memory_order_relaxed));
+        if (!best || rank < bestRank) {
+            best = endpoint;
+            bestRank = rank;
+        }
+    }
+    return best;
+}
+
+void VerifyGrpcClient::ReportResult(Endpoint& endpoint, const Status& status) {
+    switch (status.error_code()) {
+    case grpc::StatusCode::OK:
+        endpoint.consecutiveFailures.store(0, std::memory_order_relaxed);
+        endpoint.ejections.store(0, std::memory_order_relaxed);
+        return;
+    case grpc::StatusCode::UNAVAILABLE:
+    case grpc::StatusCode::DEADLINE_EXCEEDED:
+        break;
+    default:
+        //取消的是对冲输掉的请求，其余错误由服务端返回，实例本身是可用的
+        return;
+    }
+
+    int failures = endpoint.consecutiveFailures.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (failures < ejectFailures_) {
+        return;
+    }
+    //摘除期间不再有请求，到期后第一个请求就是探测；仍然失败时failures已达到阈值，立即再次摘除
+    auto now = std::chrono::steady_clock::now();
+    int64_t until = endpoint.ejectedUntil.load(std::memory_order_relaxed);
+    if (until > now.time_since_epoch().count()) {
+        return;
+    }
+    int multiplier = std::min(1 << std::min(endpoint.ejections.load(std::memory_order_relaxed), 30), VARIFY_MAX_EJECT_MULTIPLIER);
+    int64_t newUntil = (now + ejectTime_ * multiplier).time_since_epoch().count();
+    if (!endpoint.ejectedUntil.compare_exchange_strong(until, newUntil, std::memory_order_relaxed)) {
+        return;
+    }
+    endpoint.ejections.fetch_add(1, std::memory_order_relaxed);
+    ejections_.fetch_add(1, std::memory_order_relaxed);
+    std::cout << "VarifyServer " << endpoint.target << " ejected for " << (ejectTime_ * multiplier).count()
+              << "ms after " << failures << " consecutive failures" << std::endl;
+}
+
+net::awaitable<GetVarifyRsp> VerifyGrpcClient::AsyncGetVarifyCode(std::string email, std::chrono::steady_clock::time_point deadline) {
+    deadline = std::min(deadline, std::chrono::steady_clock::now() + timeout_);
+    calls_.fetch_add(1, std::memory_order_relaxed);
+    inflight_.fetch_add(1, std::memory_order_relaxed);
+    budget_.Deposit();
+
+    GetVarifyRsp reply = co_await net::async_initiate<decltype(net::use_awaitable), void(GetVarifyRsp)>(
+        [this, &email, deadline](auto handler) {
+            auto executor = net::get_associated_executor(handler);
+            //use_awaitable的handler只能移动，std::function需要可拷贝，放进shared_ptr里
+            auto shared = std::make_shared<decltype(handler)>(std::move(handler));
+            auto call = std::make_shared<Call>(this, std::move(email), deadline, executor,
+                [shared](GetVarifyRsp reply) {
+                    (*shared)(std::move(reply));
+                });
+            call->Start();
+        }, net::use_awaitable);
+
+    inflight_.fetch_sub(1, std::memory_order_relaxed);
+    co_return reply;
+}
+
+VerifyClientStats VerifyGrpcClient::GetStats() const {
+    VerifyClientStats stats;
+    stats.calls = calls_.load(std::memory_order_relaxed);
+    stats.failures = failures_.load(std::memory_order_relaxed);
+    stats.inflight = inflight_.load(std::memory_order_relaxed);
+    stats.retries = retries_.load(std::memory_order_relaxed);
+    stats.hedges = hedges_.load(std::memory_order_relaxed);
+    stats.budgetExhausted = budgetExhausted_.load(std::memory_order_relaxed);
+    stats.ejections = ejections_.load(std::memory_order_relaxed);
+    stats.endpoints = static_cast<int>(endpoints_.size());
+    stats.healthy = 0;
+    int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+    for (auto& endpoint : endpoints_) {
+        if (endpoint->ejectedUntil.load(std::memory_order_relaxed) <= now) {
+            ++stats.healthy;
+        }
+    }
+    return stats;
+}
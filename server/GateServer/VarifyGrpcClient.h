@@ -11,102 +11,94 @@ using message::GetVarifyReq;
 using message::GetVarifyRsp;
 using message::VarifyService;
 
-class RPConPool {
-public:
-    RPConPool(size_t poolSize, std::string host, std::string port)
-        : poolSize_(poolSize), host_(host), port_(port), b_stop_(false) {
-        for (size_t i = 0; i < poolSize_; ++i) {
-
-            std::shared_ptr<Channel> channel = grpc::CreateChannel(host + ":" + port,
-                grpc::InsecureChannelCredentials());
-
-            connections_.push(VarifyService::NewStub(channel));
-        }
-    }
-
-    ~RPConPool() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        Close();
-        while (!connections_.empty()) {
-            connections_.pop();
-        }
-    }
+//֤ͳ
+struct VerifyClientStats {
+    uint64_t calls;      //ĵ
+    uint64_t failures;   //ʧ(ֹʱ)ĵ
+    uint64_t inflight;   //ǰδɵĵ
+    uint64_t retries;    //ʧܺԵ
+    uint64_t hedges;     //״ٳûӦʱĶԳ
+    uint64_t budgetExhausted;   //ΪԤ/Գ
+    uint64_t ejections;  //ʵʧܱժĴ
+    int endpoints;       //õʵ
+    int healthy;         //ǰûбժʵ
+};
 
-    std::unique_ptr<VarifyService::Stub> getConnection() {
-        std::unique_lock<std::mutex> lock(mutex_);
-        cond_.wait(lock, [this] {
-            if (b_stop_) {
-                return true;
-            }
-            return !connections_.empty();
-        });
-        //ֱֹͣӷؿָ
-        if (b_stop_) {
-            return  nullptr;
-        }
-		//Ϊstub_unique_ptrҪstd::move
-        auto context = std::move(connections_.front());
-        connections_.pop();
-        return context;
-    }
+//Ԥ㣺ÿôpercent%Ķȣÿ벹minPerSecond
+//ԺͶԳһʱһڣѹϷŴ
+class RetryBudget {
+public:
+    RetryBudget(int percent, int minPerSecond);
 
-    void returnConnection(std::unique_ptr<VarifyService::Stub> context) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (b_stop_) {
-            return;
-        }
-        connections_.push(std::move(context));
-        cond_.notify_one();
-    }
+    //¼һ
+    void Deposit();
 
-    void Close() {
-        b_stop_ = true;
-        cond_.notify_all();
-    }
+    //ȡһĶȣԤ㲻㷵false
+    bool TryWithdraw();
 
 private:
-    std::atomic<bool> b_stop_;
-    size_t poolSize_;
-    std::string host_;
-    std::string port_;
-    std::queue<std::unique_ptr<VarifyService::Stub>> connections_;
     std::mutex mutex_;
-    std::condition_variable cond_;
+    double balance_;
+    double ratio_;
+    double minPerSecond_;
+    std::chrono::steady_clock::time_point lastRefill_;
 };
 
+//֤첽gRPCͻˡ
+//ÿVarifyServerʵһHTTP/2ͨеͨ϶·ãҪȡһӣ
+//ͨgRPCĻصAPIȴڼ䲻ռκ̣߳ɺصõЭ̵executorϼִС
+//δٵʵʧEjectFailuresεʵժһʱ䣬
+//ں²䣬ٴʧժʱӱʵժʱ԰δ䡣
+//֤ĴֻҪEndpointsмʵ
+//ֹʱȡHTTPĽֹʱTimeoutMsнһԺͶԳֹʱ䡣
+//ʧ(UNAVAILABLE)ԤʱһʵԣHedgeDelayMsʱ
+//״󳬹ʱûӦһʵٷһȳɹӦΪȡ
+//һεõͬһidVarifyServerȥأֻһʼ
+//ʧʱӦerrorΪRPCFailed
 class VerifyGrpcClient :public Singleton<VerifyGrpcClient>
 {
     friend class Singleton<VerifyGrpcClient>;
 public:
-    GetVarifyRsp GetVarifyCode(std::string email) {
-        ClientContext context;
-        GetVarifyRsp reply;
-        GetVarifyReq request;
-        request.set_email(email);
-        auto stub = pool_->getConnection();
-        Status status = stub->GetVarifyCode(&context, request, &reply);
+    net::awaitable<GetVarifyRsp> AsyncGetVarifyCode(std::string email, std::chrono::steady_clock::time_point deadline);
 
-        if (status.ok()) {
-            pool_->returnConnection(std::move(stub));
-            return reply;
-        }
-        else {
-            pool_->returnConnection(std::move(stub));
-            reply.set_error(ErrorCodes::RPCFailed);
-            return reply;
-        }
-    }
+    VerifyClientStats GetStats() const;
 
 private:
-    VerifyGrpcClient() {
-        auto& gCfgMgr = ConfigMgr::Inst();
-        std::string host = gCfgMgr["VarifyServer"]["Host"];
-        std::string port = gCfgMgr["VarifyServer"]["Port"];
-        pool_.reset(new RPConPool(5, host, port));
-    }
+    //һεõ״̬
+    class Call;
 
-    std::unique_ptr<VarifyService::Stub> stub_;
+    //һVarifyServerʵ
+    struct Endpoint {
+        std::string target;     //host:port
+        std::unique_ptr<VarifyService::Stub> stub;
+        std::atomic<int> outstanding{ 0 };          //ѷδɵ
+        std::atomic<int> consecutiveFailures{ 0 };
+        std::atomic<int> ejections{ 0 };            //ָժĴ´ժ
+        std::atomic<int64_t> ejectedUntil{ 0 };     //steady_clock룬֮ǰ
+    };
 
-    std::unique_ptr<RPConPool> pool_;
-};
+    VerifyGrpcClient();
+
+    //ѡһʵûбժģαεûûùģδٵ
+    Endpoint* PickEndpoint(const std::vector<Endpoint*>& tried);
+
+    //¼һĽʵĽ״̬÷ȡ󲻼
+    void ReportResult(Endpoint& endpoint, const Status& status);
 
+    std::vector<std::unique_ptr<Endpoint>> endpoints_;
+    std::atomic<size_t> next_{ 0 };
+    std::chrono::milliseconds timeout_;
+    std::chrono::milliseconds hedgeDelay_;
+    int maxAttempts_;
+    RetryBudget budget_;
+
+    std::atomic<uint64_t> calls_{ 0 };
+    std::atomic<uint64_t> failures_{ 0 };
+    std::atomic<uint64_t> inflight_{ 0 };
+    std::atomic<uint64_t> retries_{ 0 };
+    std::atomic<uint64_t> hedges_{ 0 };
+    std::atomic<uint64_t> budgetExhausted_{ 0 };
+    std::atomic<uint64_t> ejections_{ 0 };
+    int ejectFailures_;
+    std::chrono::milliseconds ejectTime_;
+};
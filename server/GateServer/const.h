@@ -36,6 +36,8 @@ enum ErrorCodes {
 	RPCFailed = 1002,//RPC调用失败
 	InvalidParams = 1003, // 无效参数
 	TokenInvalid = 1004, // 验证码或令牌无效
+	ConfigReloadFailed = 1005, // 配置重新加载失败
+	Forbidden = 1006, // 管理接口只允许本机访问
 	
 	// 数据库错误码 (2000-2999)
 	DB_ERROR_BASE = 2000,
@@ -45,6 +47,7 @@ enum ErrorCodes {
 	DB_PROCEDURE_FAILED = 2004,    // 存储过程调用失败
 	DB_CONNECTION_TIMEOUT = 2005,  // 连接获取超时
 	DB_POOL_INIT_FAILED = 2006,    // 连接池初始化失败
+	DB_BUSY = 2007,                // 数据库线程池繁忙，请求被拒绝
 	
 	// 用户相关错误码 (3000-3999)
 	USER_ERROR_BASE = 3000,
@@ -72,6 +75,88 @@ enum class ConnectionState {
     EXPIRED     // 过期
 };
 
+// GateServer配置项名称常量
+const char* const GATE_CONFIG_SECTION = "GateServer";
+const char* const GATE_KEEP_ALIVE_KEY = "KeepAlive";
+const char* const GATE_IDLE_TIMEOUT_KEY = "IdleTimeout";
+const char* const GATE_REQUEST_TIMEOUT_KEY = "RequestTimeout";
+const char* const GATE_MAX_KEEP_ALIVE_REQUESTS_KEY = "MaxKeepAliveRequests";
+const char* const GATE_REUSE_PORT_KEY = "ReusePort";
+
+// HTTP长连接默认配置
+const int GATE_DEFAULT_IDLE_TIMEOUT = 60;             // 空闲超时(秒)
+const int GATE_DEFAULT_REQUEST_TIMEOUT = 10;          // 单个请求从读完到应答的处理时限(秒)
+const int GATE_DEFAULT_MAX_KEEP_ALIVE_REQUESTS = 1000; // 单连接最多处理的请求数
+
+// Redis配置项名称常量
+const char* const REDIS_CONFIG_SECTION = "Redis";
+const char* const REDIS_POOL_SIZE_KEY = "PoolSize";
+const char* const REDIS_PIN_PER_THREAD_KEY = "PinPerThread";
+
+// Redis连接池默认配置
+const int REDIS_DEFAULT_POOL_SIZE = 5;
+const int REDIS_RECONNECT_INTERVAL_MS = 1000;    // 断开的连接重连失败后，这段时间内不再尝试(毫秒)
+
+// 用户资料缓存配置项名称常量
+const char* const USER_CACHE_CONFIG_SECTION = "UserCache";
+const char* const USER_CACHE_SHARDS_KEY = "Shards";
+const char* const USER_CACHE_CAPACITY_KEY = "Capacity";
+const char* const USER_CACHE_LOCAL_TTL_KEY = "LocalTTL";
+const char* const USER_CACHE_REDIS_TTL_KEY = "RedisTTL";
+
+// 用户资料缓存默认配置
+const int USER_CACHE_DEFAULT_SHARDS = 16;
+const int USER_CACHE_DEFAULT_CAPACITY = 10000;
+const int USER_CACHE_DEFAULT_LOCAL_TTL = 60;    // 进程内缓存过期时间(秒)
+const int USER_CACHE_DEFAULT_REDIS_TTL = 600;   // Redis缓存过期时间(秒)
+const size_t USER_CACHE_MGET_CHUNK_SIZE = 500;  // 批量读取时每条MGET的最大key数
+
+// 用户状态延迟写入配置项名称常量
+const char* const WRITE_BEHIND_CONFIG_SECTION = "WriteBehind";
+const char* const WRITE_BEHIND_FLUSH_INTERVAL_KEY = "FlushIntervalMs";
+const char* const WRITE_BEHIND_BATCH_SIZE_KEY = "BatchSize";
+
+// 用户状态延迟写入默认配置
+const int WRITE_BEHIND_DEFAULT_FLUSH_INTERVAL_MS = 200;  // 定时写入间隔(毫秒)，也是异常退出时最多丢失的时间窗口
+const int WRITE_BEHIND_DEFAULT_BATCH_SIZE = 500;         // 积累到这么多个用户立即写入，也是单条语句的最大行数
+const int WRITE_BEHIND_MAX_BACKOFF_MS = 30000;           // 写入失败后重试间隔从FlushIntervalMs起翻倍，不超过这个值(毫秒)
+const int WRITE_BEHIND_MAX_ATTEMPTS = 5;                 // 同一个更新最多写这么多次，仍然失败就丢弃
+
+// 验证码服务客户端配置项名称常量
+const char* const VARIFY_CONFIG_SECTION = "VarifyServer";
+const char* const VARIFY_HOST_KEY = "Host";
+const char* const VARIFY_PORT_KEY = "Port";
+const char* const VARIFY_TIMEOUT_KEY = "TimeoutMs";
+const char* const VARIFY_ENDPOINTS_KEY = "Endpoints";
+const char* const VARIFY_MAX_ATTEMPTS_KEY = "MaxAttempts";
+const char* const VARIFY_HEDGE_DELAY_KEY = "HedgeDelayMs";
+const char* const VARIFY_RETRY_BUDGET_PERCENT_KEY = "RetryBudgetPercent";
+const char* const VARIFY_RETRY_MIN_PER_SECOND_KEY = "RetryMinPerSecond";
+const char* const VARIFY_EJECT_FAILURES_KEY = "EjectFailures";
+const char* const VARIFY_EJECT_TIME_KEY = "EjectTimeMs";
+//一次调用的所有请求(重试、对冲)都带同一个请求id，VarifyServer按它去重，只发送一封邮件
+const char* const VARIFY_REQUEST_ID_METADATA = "x-request-id";
+
+// 验证码服务客户端默认配置
+const int VARIFY_DEFAULT_TIMEOUT_MS = 3000;     // 单次调用的截止时间(毫秒)，不超过HTTP请求本身的截止时间
+const int VARIFY_DEFAULT_MAX_ATTEMPTS = 2;      // 一次调用最多发出的请求数(首次请求+重试+对冲)
+const int VARIFY_DEFAULT_HEDGE_DELAY_MS = 0;    // 首次请求这么久没有应答就向另一个实例发对冲请求，0表示不对冲
+const int VARIFY_DEFAULT_RETRY_BUDGET_PERCENT = 10;  // 重试和对冲请求最多占正常调用的百分比
+const int VARIFY_DEFAULT_RETRY_MIN_PER_SECOND = 5;   // 调用量很小时每秒至少允许的重试数
+const int VARIFY_RETRY_BUDGET_CAP = 100;        // 重试预算最多积累的请求数
+const int VARIFY_DEFAULT_EJECT_FAILURES = 3;    // 实例连续失败这么多次后暂时不再分配请求
+const int VARIFY_DEFAULT_EJECT_TIME_MS = 10000; // 首次摘除的时间(毫秒)，恢复后再次被摘除时按次数加倍
+const int VARIFY_MAX_EJECT_MULTIPLIER = 8;      // 摘除时间最多是EjectTimeMs的这么多倍
+
+// 数据库执行器配置项名称常量
+const char* const DB_EXECUTOR_CONFIG_SECTION = "DBExecutor";
+const char* const DB_EXECUTOR_THREADS_KEY = "Threads";
+const char* const DB_EXECUTOR_QUEUE_SIZE_KEY = "QueueSize";
+
+// 数据库执行器默认配置
+const int DB_EXECUTOR_DEFAULT_THREADS = 16;       // 数据库线程数，不超过连接池上限
+const int DB_EXECUTOR_DEFAULT_QUEUE_SIZE = 1000;  // 排队任务上限，超过后直接返回繁忙
+
 // 数据库配置项名称常量
 const char* const MYSQL_CONFIG_SECTION = "Mysql";
 const char* const MYSQL_HOST_KEY = "Host";
@@ -79,6 +164,20 @@ const char* const MYSQL_PORT_KEY = "Port";
 const char* const MYSQL_USER_KEY = "User";
 const char* const MYSQL_PASSWD_KEY = "Passwd";
 const char* const MYSQL_SCHEMA_KEY = "Schema";
+const char* const MYSQL_VALIDATION_WINDOW_KEY = "ValidationWindow";
+const char* const MYSQL_INITIAL_SIZE_KEY = "InitialSize";
+const char* const MYSQL_MAX_SIZE_KEY = "MaxSize";
+const char* const MYSQL_MIN_SIZE_KEY = "MinSize";
+const char* const MYSQL_MAX_IDLE_TIME_KEY = "MaxIdleTime";
+const char* const MYSQL_CONNECTION_TIMEOUT_KEY = "ConnectionTimeout";
+const char* const MYSQL_VALIDATION_INTERVAL_KEY = "ValidationInterval";
+const char* const MYSQL_EVICTION_INTERVAL_KEY = "EvictionInterval";
+const char* const MYSQL_STATEMENT_CACHE_SIZE_KEY = "StatementCacheSize";
+const char* const MYSQL_TARGET_WAIT_KEY = "TargetWaitMs";
+const char* const MYSQL_SHRINK_DELAY_KEY = "ShrinkDelay";
+const char* const MYSQL_REPLICAS_KEY = "Replicas";
+const char* const MYSQL_MAX_REPLICA_LAG_KEY = "MaxReplicaLag";
+const char* const MYSQL_REPLICA_CHECK_INTERVAL_KEY = "ReplicaCheckInterval";
 
 // 数据库连接池默认配置
 const int DB_DEFAULT_INITIAL_SIZE = 5;
@@ -87,7 +186,20 @@ const int DB_DEFAULT_MIN_SIZE = 5;
 const int DB_DEFAULT_MAX_IDLE_TIME = 60;
 const int DB_DEFAULT_TIMEOUT = 30;
 const int DB_DEFAULT_VALIDATION_INTERVAL = 30;
+const int DB_DEFAULT_VALIDATION_WINDOW = 10;       // 连接在这么多秒内用过或检查过，借出时不再ping
 const int DB_DEFAULT_EVICTION_INTERVAL = 30;
 const int DB_DEFAULT_MAX_WAIT_QUEUE_SIZE = 1000;
+const int DB_DEFAULT_STATEMENT_CACHE_SIZE = 32;    // 每个连接缓存的预处理语句数
+const int DB_BULK_LOOKUP_CHUNK_SIZE = 512;         // 批量查询用户时每条IN语句的最大id数，需为2的幂
+const size_t DB_BATCH_ARENA_BYTES = 4096;          // 批量查询用户时每个请求的栈上临时内存，超出部分从堆上分配
+const int FRIEND_PAGE_DEFAULT_LIMIT = 100;         // 好友列表每页默认条数
+const int FRIEND_PAGE_MAX_LIMIT = 500;             // 好友列表每页最大条数
+const int FRIEND_SYNC_OVERLAP_MS = 10000;          // 增量同步版本号往前留的重叠时间(毫秒)，覆盖未提交的事务；副本延迟上限另外加上
+const int DB_DEFAULT_TARGET_WAIT_MS = 5;           // 借连接平均等待超过该值(毫秒)时扩容
+const int DB_DEFAULT_SHRINK_DELAY = 30;            // 持续空闲多少秒后开始回收多余连接
+const int DB_POOL_CONTROL_INTERVAL_MS = 1000;      // 扩缩容控制周期(毫秒)
+const int DB_POOL_CAPACITY_LIMIT = 256;            // 运行时调整MaxSize的上限
+const int DB_DEFAULT_MAX_REPLICA_LAG = 5;          // 只读副本复制延迟超过该值(秒)时不再分配读请求
+const int DB_DEFAULT_REPLICA_CHECK_INTERVAL = 5;   // 副本复制延迟检查间隔(秒)
 
 class ConfigMgr;
@@ -0,0 +1,52 @@
+#include "AsyncUserDAO.h"
+
+net::awaitable<DAOResult<void>> AsyncUserDAO::addUser(const UserEntity& user) {
+    return run<void>([user](UserDAO& dao) { return dao.addUser(user); });
+}
+
+net::awaitable<DAOResult<UserEntity>> AsyncUserDAO::findByUsername(const std::string& username) {
+    return run<UserEntity>([username](UserDAO& dao) { return dao.findByUsername(username); });
+}
+
+net::awaitable<DAOResult<UserEntity>> AsyncUserDAO::findById(int64_t userId) {
+    return run<UserEntity>([userId](UserDAO& dao) { return dao.findById(userId); });
+}
+
+net::awaitable<DAOResult<void>> AsyncUserDAO::updateUserStatus(int64_t userId, UserStatus status) {
+    return run<void>([userId, status](UserDAO& dao) { return dao.updateUserStatus(userId, status); });
+}
+
+net::awaitable<DAOResult<void>> AsyncUserDAO::updateLastLoginTime(int64_t userId) {
+    return run<void>([userId](UserDAO& dao) { return dao.updateLastLoginTime(userId); });
+}
+
+net::awaitable<DAOResult<std::vector<UserEntity>>> AsyncUserDAO::getFriendList(int64_t userId) {
+    return run<std::vector<UserEntity>>([userId](UserDAO& dao) { return dao.getFriendList(userId); });
+}
+
+net::awaitable<DAOResult<FriendPage>> AsyncUserDAO::getFriendPage(int64_t userId, int64_t afterId, int limit, int64_t sinceVersion,
+                                                                  int64_t syncVersion, std::function<void(const FriendRow&)> onRow) {
+    return run<FriendPage>([userId, afterId, limit, sinceVersion, syncVersion, onRow = std::move(onRow)](UserDAO& dao) {
+        return dao.getFriendPage(userId, afterId, limit, sinceVersion, syncVersion, onRow);
+    });
+}
+
+net::awaitable<DAOResult<bool>> AsyncUserDAO::verifyPassword(const std::string& username, const std::string& password) {
+    return run<bool>([username, password](UserDAO& dao) { return dao.verifyPassword(username, password); });
+}
+
+net::awaitable<DAOResult<UserEntity>> AsyncUserDAO::login(const std::string& username, const std::string& password) {
+    return run<UserEntity>([username, password](UserDAO& dao) { return dao.login(username, password); });
+}
+
+net::awaitable<DAOResult<void>> AsyncUserDAO::addFriend(int64_t userId, int64_t friendId) {
+    return run<void>([userId, friendId](UserDAO& dao) { return dao.addFriend(userId, friendId); });
+}
+
+net::awaitable<DAOResult<void>> AsyncUserDAO::removeFriend(int64_t userId, int64_t friendId) {
+    return run<void>([userId, friendId](UserDAO& dao) { return dao.removeFriend(userId, friendId); });
+}
+
+net::awaitable<DAOResult<std::vector<UserEntity>>> AsyncUserDAO::batchGetUserInfo(const std::vector<int64_t>& userIds) {
+    return run<std::vector<UserEntity>>([userIds](UserDAO& dao) { return dao.batchGetUserInfo(userIds); });
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "UserDAO.h"
+#include "DBExecutor.h"
+
+// UserDAO的协程版本：调用在DBExecutor的数据库线程上执行，io_context线程只负责挂起和恢复。
+// 数据库线程池排满时不排队等待，直接返回失败结果(isSuccess()为false，消息为DB_BUSY_MESSAGE)。
+class AsyncUserDAO {
+public:
+    static constexpr const char* DB_BUSY_MESSAGE = "数据库繁忙";
+
+    net::awaitable<DAOResult<void>> addUser(const UserEntity& user);
+
+    net::awaitable<DAOResult<UserEntity>> findByUsername(const std::string& username);
+
+    net::awaitable<DAOResult<UserEntity>> findById(int64_t userId);
+
+    net::awaitable<DAOResult<void>> updateUserStatus(int64_t userId, UserStatus status);
+
+    net::awaitable<DAOResult<void>> updateLastLoginTime(int64_t userId);
+
+    net::awaitable<DAOResult<std::vector<UserEntity>>> getFriendList(int64_t userId);
+
+    // onRow在数据库线程上逐行调用，调用方在co_await返回前不能访问onRow写入的数据
+    net::awaitable<DAOResult<FriendPage>> getFriendPage(int64_t userId, int64_t afterId, int limit, int64_t sinceVersion,
+                                                        int64_t syncVersion, std::function<void(const FriendRow&)> onRow);
+
+    net::awaitable<DAOResult<bool>> verifyPassword(const std::string& username, const std::string& password);
+
+    net::awaitable<DAOResult<UserEntity>> login(const std::string& username, const std::string& password);
+
+    net::awaitable<DAOResult<void>> addFriend(int64_t userId, int64_t friendId);
+
+    net::awaitable<DAOResult<void>> removeFriend(int64_t userId, int64_t friendId);
+
+    net::awaitable<DAOResult<std::vector<UserEntity>>> batchGetUserInfo(const std::vector<int64_t>& userIds);
+
+private:
+    // 把对UserDAO的调用交给数据库线程池，参数按值捕获，调用方的引用不会跨越挂起点
+    template <typename T, typename Func>
+    static net::awaitable<DAOResult<T>> run(Func func) {
+        auto result = co_await DBExecutor::GetInstance()->TryRun(
+            [func = std::move(func)]() mutable -> DAOResult<T> {
+                UserDAO dao;
+                return func(dao);
+            });
+        if (!result) {
+            co_return DAOResult<T>(false, DB_BUSY_MESSAGE);
+        }
+        co_return std::move(*result);
+    }
+};
@@ -76,13 +76,103 @@ private:
         return DAOResult<result_type>(false, "未知错误"); \
     }
 
+// 读操作的路由：PRIMARY读主库，能读到刚写入的数据；
+// REPLICA读只读副本，可能有几秒的复制延迟，适合不要求读到最新写入的查询
+enum class ReadRoute {
+    PRIMARY,
+    REPLICA
+};
+
 class BaseDAO {
 protected:
-    // 获取数据库连接
+    // 是否是连接层面的错误(服务器断开、连接丢失)，这类错误说明连接已不可用
+    static bool isConnectionError(const sql::SQLException& e) {
+        switch (e.getErrorCode()) {
+        case 2002:  // CR_CONNECTION_ERROR
+        case 2003:  // CR_CONN_HOST_ERROR
+        case 2006:  // CR_SERVER_GONE_ERROR
+        case 2013:  // CR_SERVER_LOST
+        case 2014:  // CR_COMMANDS_OUT_OF_SYNC，连接上还有没读完的结果，只能换连接
+        case 2055:  // CR_SERVER_LOST_EXTENDED
+            return true;
+        default:
+            return e.getSQLState().compare(0, 2, "08") == 0;
+        }
+    }
+    
+    // 执行幂等的读操作：查询本身报连接错误时，把连接标记为损坏(归还时由连接池关闭)，
+    // 换一个连接透明地重试一次。借出连接时不再每次ping，失效的连接靠这里发现；
+    // 重试用的连接一定先ping过，不会又拿到一个同样失效的空闲连接。
+    template<typename Func>
+    auto executeRead(Func func) -> decltype(func(std::declval<ConnectionWrapper*>())) {
+        return executeRead(ReadRoute::PRIMARY, std::move(func));
+    }
+    
+    // 同上，route为REPLICA时读只读副本，重试时可能换到另一个副本
+    template<typename Func>
+    auto executeRead(ReadRoute route, Func func) -> decltype(func(std::declval<ConnectionWrapper*>())) {
+        {
+            auto connWrapper = getConnection(route);
+            try {
+                return func(connWrapper.get());
+            } catch (const sql::SQLException& e) {
+                if (!isConnectionError(e)) {
+                    throw;
+                }
+                connWrapper->setState(ConnectionState::BROKEN);
+            }
+        }
+        auto connWrapper = getConnection(route, true);
+        try {
+            return func(connWrapper.get());
+        } catch (const sql::SQLException& e) {
+            if (isConnectionError(e)) {
+                connWrapper->setState(ConnectionState::BROKEN);
+            }
+            throw;
+        }
+    }
+    
+    // 执行边读边把结果交给调用方的读操作：调用方已经收到的行无法撤回，所以不重试。
+    // 为此借出的连接一定先ping过，用不着靠重试来发现失效的空闲连接
+    template<typename Func>
+    auto executeStreamingRead(ReadRoute route, Func func) -> decltype(func(std::declval<ConnectionWrapper*>())) {
+        auto connWrapper = getConnection(route, true);
+        try {
+            return func(connWrapper.get());
+        } catch (const sql::SQLException& e) {
+            if (isConnectionError(e)) {
+                connWrapper->setState(ConnectionState::BROKEN);
+            }
+            throw;
+        }
+    }
+    
+    // 执行写操作：不重试(无法确定服务器是否已经执行)，只在连接错误时标记连接损坏
+    template<typename Func>
+    auto executeWrite(Func func) -> decltype(func(std::declval<ConnectionWrapper*>())) {
+        auto connWrapper = getConnection();
+        try {
+            return func(connWrapper.get());
+        } catch (const sql::SQLException& e) {
+            if (isConnectionError(e)) {
+                connWrapper->setState(ConnectionState::BROKEN);
+            }
+            throw;
+        }
+    }
+
+    // 获取数据库连接(主库)
     std::shared_ptr<ConnectionWrapper> getConnection() {
         return gDBManager.getConnection();
     }
     
+    // 按读路由获取连接，没有可用副本时DBManager退回主库；validate为true时借出前一定ping
+    std::shared_ptr<ConnectionWrapper> getConnection(ReadRoute route, bool validate = false) {
+        return route == ReadRoute::REPLICA ? gDBManager.getReadConnection(0, validate)
+                                           : gDBManager.getConnection(0, validate);
+    }
+    
     // 调用存储过程 - 无参数版本
     std::shared_ptr<sql::ResultSet> callProcedure(
         const std::string& procName, sql::Connection* conn) {
@@ -128,6 +218,33 @@ protected:
             conn->prepareStatement(sql));
     }
     
+    // 调用存储过程 - 使用连接上缓存的预处理语句，同一过程和参数个数只在第一次调用时预处理。
+    // CALL在结果集之后还有一个状态结果，缓存的语句不会随析构释放它，
+    // 所以返回的语句用完(最后一个引用释放)时读掉剩余结果，读不掉的连接标记为损坏
+    std::shared_ptr<sql::PreparedStatement> prepareProcedureCall(
+        const std::string& procName, int paramCount,
+        ConnectionWrapper* connWrapper) {
+        
+        std::string sql = "CALL " + procName + "(";
+        for (int i = 0; i < paramCount; ++i) {
+            if (i > 0) {
+                sql += ", ";
+            }
+            sql += "?";
+        }
+        sql += ")";
+        
+        auto stmt = connWrapper->prepareCached(sql);
+        return std::shared_ptr<sql::PreparedStatement>(stmt.get(), [stmt, connWrapper](sql::PreparedStatement*) {
+            try {
+                while (stmt->getMoreResults()) {
+                }
+            } catch (...) {
+                connWrapper->setState(ConnectionState::BROKEN);
+            }
+        });
+    }
+    
     // 调用存储过程 - 执行更新操作（无结果集返回）
     int callProcedureForUpdate(
         const std::string& procName,
@@ -201,23 +318,36 @@ protected:
             conn->setAutoCommit(autoCommit);
             
             return result;
-        } catch (...) {
-            // 回滚事务
-            try {
-                conn->rollback();
-            } catch (...) {
-                // 忽略回滚过程中的异常
-            }
-            
-            // 恢复原始自动提交状态
-            try {
-                conn->setAutoCommit(autoCommit);
-            } catch (...) {
-                // 忽略状态恢复过程中的异常
+        } catch (const sql::SQLException& e) {
+            if (isConnectionError(e)) {
+                // 连接已断开，回滚没有意义，标记损坏后由连接池关闭
+                connWrapper->setState(ConnectionState::BROKEN);
+                throw;
             }
+            rollbackQuietly(conn, autoCommit);
+            throw;
+        } catch (...) {
+            rollbackQuietly(conn, autoCommit);
             
             // 重新抛出异常
             throw;
         }
     }
+    
+    // 回滚事务并恢复自动提交状态，忽略过程中的异常
+    static void rollbackQuietly(sql::Connection* conn, bool autoCommit) {
+        // 回滚事务
+        try {
+            conn->rollback();
+        } catch (...) {
+            // 忽略回滚过程中的异常
+        }
+        
+        // 恢复原始自动提交状态
+        try {
+            conn->setAutoCommit(autoCommit);
+        } catch (...) {
+            // 忽略状态恢复过程中的异常
+        }
+    }
 }; 
\ No newline at end of file
@@ -1,39 +1,42 @@
 #include "DBConnectionPool.h"
 #include <sstream>
 #include <iostream>
+#include <limits>
 
 bool DBConnectionPool::init(const DBPoolConfig& config) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
     if (m_running) {
         return false; // Already initialized
     }
     
     try {
         m_config = config;
+        applyConfig(config);
+        // Sized for the largest MaxSize a reload may ask for
+        m_idleConnections = std::make_unique<MPMCQueue<ConnectionWrapper*>>(DB_POOL_CAPACITY_LIMIT);
         
         // Get driver instance
         m_driver = get_driver_instance();
         
         // Initialize connection pool
-        for (int i = 0; i < m_config.initialSize; ++i) {
-            auto conn = createConnection();
+        int initialSize = std::min(m_config.initialSize, m_maxSize.load());
+        for (int i = 0; i < initialSize; ++i) {
+            ConnectionWrapper* conn = reserveSlot() ? createConnection() : nullptr;
             if (conn) {
-                m_idleConnections.push(conn);
-                m_allConnections.push_back(conn);
+                pushIdle(conn);
             } else {
                 // Unable to create initial connections, clean up and return failure
-                for (auto c : m_allConnections) {
-                    delete c;
-                }
-                m_allConnections.clear();
-                while (!m_idleConnections.empty()) {
-                    m_idleConnections.pop();
+                while (m_idleConnections->TryPop(conn)) {
+                    closeConnection(conn);
                 }
+                m_idleCount = 0;
                 return false;
             }
         }
         
+        m_targetIdle = m_minSize.load();
+        m_idleLowWater = m_idleCount.load();
+        m_calmLowWater = m_idleCount.load();
+        
         // Start maintenance threads
         m_running = true;
         m_heartbeatThread = std::thread(&DBConnectionPool::heartbeatChecker, this);
@@ -49,6 +52,35 @@ bool DBConnectionPool::init(const DBPoolConfig& config) {
     }
 }
 
+void DBConnectionPool::applyConfig(const DBPoolConfig& config) {
+    int maxSize = std::clamp(config.maxSize, 1, DB_POOL_CAPACITY_LIMIT);
+    m_maxSize = maxSize;
+    m_minSize = std::clamp(config.minSize, 0, maxSize);
+    m_maxIdleTime = config.maxIdleTime;
+    m_connectionTimeout = config.connectionTimeout;
+    m_validationInterval = std::max(config.validationInterval, 1);
+    m_validationWindow = config.validationWindow;
+    m_evictionInterval = std::max(config.timeBetweenEvictionRuns, 1);
+    m_targetWaitMs = config.targetWaitMs;
+    m_shrinkDelay = config.shrinkDelay;
+}
+
+void DBConnectionPool::reconfigure(const DBPoolConfig& config) {
+    applyConfig(config);
+    // Let the manager thread grow or trim towards the new limits right away
+    requestGrowth();
+}
+
+bool DBConnectionPool::reserveSlot() {
+    int total = m_totalConnections.load();
+    while (total < m_maxSize) {
+        if (m_totalConnections.compare_exchange_weak(total, total + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 ConnectionWrapper* DBConnectionPool::createConnection() {
     try {
         auto* conn = m_driver->connect(m_config.host, m_config.user, m_config.password);
@@ -57,7 +89,11 @@ ConnectionWrapper* DBConnectionPool::createConnection() {
         // Set connection properties
         // For example: conn->setClientOption("OPT_CONNECT_TIMEOUT", "10");
         
-        auto wrapper = new ConnectionWrapper(conn, m_nextConnectionId++);
+        auto wrapper = new ConnectionWrapper(conn, m_nextConnectionId++, m_config.statementCacheSize);
+        {
+            std::lock_guard<std::mutex> lock(m_registryMutex);
+            m_allConnections.insert(wrapper);
+        }
         
         // Execute callback
         if (m_onConnectionCreate) {
@@ -67,86 +103,90 @@ ConnectionWrapper* DBConnectionPool::createConnection() {
         return wrapper;
     } catch (const sql::SQLException& e) {
         std::cerr << "Failed to create connection: " << e.what() << std::endl;
+        // Give the reserved slot back
+        --m_totalConnections;
         return nullptr;
     }
 }
 
-std::shared_ptr<ConnectionWrapper> DBConnectionPool::getConnection(int timeoutSeconds) {
-    // Increase waiting thread count
-    ++m_waitingThreads;
-    
-    // Ensure waiting thread count is decreased on function exit
-    struct ScopeGuard {
-        std::atomic<int>& counter;
-        ScopeGuard(std::atomic<int>& c) : counter(c) {}
-        ~ScopeGuard() { --counter; }
-    } guard(m_waitingThreads);
-    
-    ConnectionWrapper* conn = nullptr;
+std::shared_ptr<ConnectionWrapper> DBConnectionPool::getConnection(int timeoutSeconds, bool validate) {
+    auto waitTime = timeoutSeconds > 0 
+        ? std::chrono::seconds(timeoutSeconds) 
+        : std::chrono::seconds(m_connectionTimeout.load());
+    std::chrono::steady_clock::time_point waitStart{};
+    std::chrono::steady_clock::time_point deadline{};
     
-    {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        
-        auto waitTime = timeoutSeconds > 0 
-            ? std::chrono::seconds(timeoutSeconds) 
-            : std::chrono::seconds(m_config.connectionTimeout);
+    while (true) {
+        if (!m_running) {
+            throw std::runtime_error("Connection pool is closed");
+        }
         
-        // Wait for available connection or timeout
-        bool timeout = false;
-        while (!m_running || (m_idleConnections.empty() && m_allConnections.size() >= m_config.maxSize)) {
-            if (!m_running) {
-                throw std::runtime_error("Connection pool is closed");
+        // Fast path: take an idle connection without locking.
+        // Recently used connections are lent without a ping; a connection that
+        // died in the meantime surfaces as an SQLException in the DAO instead.
+        ConnectionWrapper* conn = nullptr;
+        if (m_idleConnections->TryPop(conn)) {
+            recordIdleLowWater(--m_idleCount);
+            if ((validate || needsValidation(conn)) && !validateConnection(conn)) {
+                closeConnection(conn);
+                continue;
             }
-            
-            if (waitTime.count() > 0) {
-                // Wait for condition variable notification or timeout
-                if (m_condition.wait_for(lock, waitTime) == std::cv_status::timeout) {
-                    timeout = true;
-                    break;
-                }
-            } else {
-                // No timeout limit, wait indefinitely
-                m_condition.wait(lock);
+            if (waitStart != std::chrono::steady_clock::time_point{}) {
+                recordWait(waitStart);
             }
+            return lend(conn);
         }
         
-        if (timeout) {
-            throw std::runtime_error("Connection acquisition timeout");
+        // No idle connection. Connections are only opened on the manager
+        // thread, so ask it to grow the pool and wait for a push.
+        if (waitStart == std::chrono::steady_clock::time_point{}) {
+            waitStart = std::chrono::steady_clock::now();
+            deadline = waitStart + waitTime;
         }
+        ++m_waitingThreads;
+        struct ScopeGuard {
+            std::atomic<int>& counter;
+            ScopeGuard(std::atomic<int>& c) : counter(c) {}
+            ~ScopeGuard() { --counter; }
+        } guard(m_waitingThreads);
+        requestGrowth();
         
-        if (!m_idleConnections.empty()) {
-            // Get and remove the front connection
-            conn = m_idleConnections.front();
-            m_idleConnections.pop();
-            
-            // Validate connection
-            if (!validateConnection(conn)) {
-                closeConnection(conn);
-                
-                // Create new connection
-                conn = createConnection();
-                if (!conn) {
-                    throw std::runtime_error("Unable to create database connection");
-                }
-            }
-            
-            // Mark as in use
-            conn->setState(ConnectionState::IN_USE);
-            m_activeConnections.insert(conn);
-        } else if (m_allConnections.size() < m_config.maxSize) {
-            // Create new connection
-            conn = createConnection();
-            if (conn) {
-                conn->setState(ConnectionState::IN_USE);
-                m_allConnections.push_back(conn);
-                m_activeConnections.insert(conn);
+        // Re-check under the lock so a push between the pop above and the
+        // wait is not missed.
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_idleCount > 0 || !m_running) {
+            continue;
+        }
+        if (waitTime.count() > 0) {
+            if (m_condition.wait_until(lock, deadline) == std::cv_status::timeout
+                && m_idleCount <= 0) {
+                recordWait(waitStart);
+                throw std::runtime_error("Connection acquisition timeout");
             }
+        } else {
+            // No timeout limit, wait indefinitely
+            m_condition.wait(lock);
         }
     }
-    
-    if (!conn) {
-        throw std::runtime_error("Unable to acquire database connection");
+}
+
+void DBConnectionPool::recordIdleLowWater(int idle) {
+    idle = std::max(idle, 0);
+    int low = m_idleLowWater.load(std::memory_order_relaxed);
+    while (idle < low && !m_idleLowWater.compare_exchange_weak(low, idle, std::memory_order_relaxed)) {
     }
+}
+
+void DBConnectionPool::recordWait(std::chrono::steady_clock::time_point waitStart) {
+    auto waited = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - waitStart).count();
+    m_slowAcquires.fetch_add(1, std::memory_order_relaxed);
+    m_slowWaitUs.fetch_add(static_cast<uint64_t>(waited), std::memory_order_relaxed);
+}
+
+std::shared_ptr<ConnectionWrapper> DBConnectionPool::lend(ConnectionWrapper* conn) {
+    conn->setState(ConnectionState::IN_USE);
+    ++m_activeConnections;
     
     // Execute connection acquisition callback
     if (m_onConnectionAcquire) {
@@ -167,38 +207,37 @@ void DBConnectionPool::releaseConnection(ConnectionWrapper* conn) {
         m_onConnectionRelease(conn);
     }
     
-    std::lock_guard<std::mutex> lock(m_mutex);
+    --m_activeConnections;
     
-    if (!m_running) {
+    if (!m_running || conn->getState() == ConnectionState::BROKEN
+        || m_totalConnections > m_maxSize) {
+        // Broken connections are dropped and the manager thread opens a
+        // replacement if anyone is waiting; connections above a lowered
+        // MaxSize are dropped as they come back
         closeConnection(conn);
         return;
     }
     
-    // Remove from active connections set
-    auto it = m_activeConnections.find(conn);
-    if (it != m_activeConnections.end()) {
-        m_activeConnections.erase(it);
+    // Mark as idle and return to pool
+    conn->setState(ConnectionState::IDLE);
+    pushIdle(conn);
+}
+
+void DBConnectionPool::pushIdle(ConnectionWrapper* conn) {
+    if (!m_idleConnections->TryPush(conn)) {
+        // Cannot happen while total <= maxSize, but never leak a connection
+        closeConnection(conn);
+        return;
     }
-    
-    // Check connection state
-    if (conn->getState() == ConnectionState::BROKEN) {
-        // Destroy and create new connection
-        auto pos = std::find(m_allConnections.begin(), m_allConnections.end(), conn);
-        if (pos != m_allConnections.end()) {
-            *pos = createConnection();
-            if (*pos) {
-                m_idleConnections.push(*pos);
-            }
-        }
-        delete conn;
-    } else {
-        // Mark as idle and return to pool
-        conn->setState(ConnectionState::IDLE);
-        m_idleConnections.push(conn);
+    ++m_idleCount;
+    notifyWaiter();
+}
+
+void DBConnectionPool::notifyWaiter() {
+    if (m_waitingThreads > 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_condition.notify_one();
     }
-    
-    // Notify waiting threads
-    m_condition.notify_one();
 }
 
 bool DBConnectionPool::validateConnection(ConnectionWrapper* conn) {
@@ -212,17 +251,29 @@ bool DBConnectionPool::validateConnection(ConnectionWrapper* conn) {
     }
 }
 
+bool DBConnectionPool::needsValidation(ConnectionWrapper* conn) const {
+    int window = m_validationWindow.load(std::memory_order_relaxed);
+    if (window <= 0) {
+        return true;
+    }
+    return std::chrono::steady_clock::now() - conn->getLastValidTime()
+        > std::chrono::seconds(window);
+}
+
 void DBConnectionPool::shutdown() {
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (!m_running) {
-            return;
-        }
-        m_running = false;
+    if (!m_running.exchange(false)) {
+        return;
     }
     
     // Notify all waiting threads
-    m_condition.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_condition.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_stopMutex);
+        m_stopCondition.notify_all();
+    }
     
     // Wait for management threads to end
     if (m_heartbeatThread.joinable()) {
@@ -233,117 +284,192 @@ void DBConnectionPool::shutdown() {
         m_managerThread.join();
     }
     
-    // Clean up all connections
-    std::lock_guard<std::mutex> lock(m_mutex);
-    for (auto conn : m_allConnections) {
-        delete conn;
-    }
-    
-    m_allConnections.clear();
-    m_activeConnections.clear();
-    while (!m_idleConnections.empty()) {
-        m_idleConnections.pop();
+    // Close idle connections; borrowed ones are closed when they are released
+    ConnectionWrapper* conn = nullptr;
+    while (m_idleConnections->TryPop(conn)) {
+        --m_idleCount;
+        closeConnection(conn);
     }
 }
 
+bool DBConnectionPool::sleepFor(std::chrono::seconds duration) {
+    std::unique_lock<std::mutex> lock(m_stopMutex);
+    return !m_stopCondition.wait_for(lock, duration, [this] { return !m_running; });
+}
+
 void DBConnectionPool::heartbeatChecker() {
-    while (m_running) {
-        std::this_thread::sleep_for(std::chrono::seconds(m_config.validationInterval));
-        
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (!m_running) break;
-        
-        // Check idle connections
-        std::queue<ConnectionWrapper*> tempQueue;
-        while (!m_idleConnections.empty()) {
-            auto conn = m_idleConnections.front();
-            m_idleConnections.pop();
-            
-            if (validateConnection(conn)) {
-                tempQueue.push(conn);
+    while (sleepFor(std::chrono::seconds(m_validationInterval.load()))) {
+        // Check idle connections one at a time, without any lock held,
+        // so at most one connection is out of circulation while it is pinged.
+        // Connections confirmed within the validation window are skipped.
+        int count = m_idleCount.load();
+        for (int i = 0; i < count && m_running; ++i) {
+            ConnectionWrapper* conn = nullptr;
+            if (!m_idleConnections->TryPop(conn)) {
+                break;
+            }
+            --m_idleCount;
+            if (!needsValidation(conn) || validateConnection(conn)) {
+                pushIdle(conn);
             } else {
                 closeConnection(conn);
             }
         }
-        
-        // Restore available connections
-        m_idleConnections = std::move(tempQueue);
+    }
+}
+
+bool DBConnectionPool::waitForWork(std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(m_stopMutex);
+    m_stopCondition.wait_for(lock, duration, [this] { return !m_running || m_growRequested; });
+    m_growRequested = false;
+    return m_running;
+}
+
+void DBConnectionPool::requestGrowth() {
+    if (!m_growRequested.exchange(true)) {
+        std::lock_guard<std::mutex> lock(m_stopMutex);
+        m_stopCondition.notify_all();
     }
 }
 
 void DBConnectionPool::connectionManager() {
-    while (m_running) {
-        std::this_thread::sleep_for(std::chrono::seconds(m_config.timeBetweenEvictionRuns));
-        
-        std::lock_guard<std::mutex> lock(m_mutex);
-        if (!m_running) break;
-        
+    auto lastRun = std::chrono::steady_clock::now();
+    auto lastEviction = lastRun;
+    
+    while (waitForWork(std::chrono::milliseconds(DB_POOL_CONTROL_INTERVAL_MS))) {
         auto now = std::chrono::steady_clock::now();
+        adjustTarget(std::chrono::duration_cast<std::chrono::milliseconds>(now - lastRun));
+        lastRun = now;
         
-        // Check idle connections
-        std::queue<ConnectionWrapper*> tempQueue;
-        size_t idleCount = m_idleConnections.size();
+        if (now - lastEviction >= std::chrono::seconds(m_evictionInterval.load())) {
+            evictIdle();
+            lastEviction = now;
+        }
         
-        while (!m_idleConnections.empty()) {
-            auto conn = m_idleConnections.front();
-            m_idleConnections.pop();
-            
-            auto idleTime = std::chrono::duration_cast<std::chrono::seconds>(
-                now - conn->getLastAccessTime()).count();
-            
-            // If idle time exceeds maximum value and idle connection count is greater than minimum value, close
-            if (idleTime > m_config.maxIdleTime && idleCount > m_config.minSize) {
-                closeConnection(conn);
-                idleCount--;
-            } else {
-                tempQueue.push(conn);
+        // A lowered MaxSize: idle connections go now, borrowed ones on release
+        int excess = m_totalConnections - m_maxSize;
+        if (excess > 0) {
+            closeIdle(excess);
+        }
+        
+        prewarm();
+    }
+}
+
+void DBConnectionPool::adjustTarget(std::chrono::milliseconds elapsed) {
+    uint64_t slowAcquires = m_slowAcquires.exchange(0);
+    uint64_t slowWaitUs = m_slowWaitUs.exchange(0);
+    int waiting = m_waitingThreads.load();
+    int lowWater = m_idleLowWater.exchange(std::max(m_idleCount.load(), 0));
+    int minSize = m_minSize.load();
+    int target = m_targetIdle.load();
+    
+    uint64_t avgWaitMs = slowAcquires > 0 ? slowWaitUs / slowAcquires / 1000 : 0;
+    if (waiting > 0 || avgWaitMs > static_cast<uint64_t>(m_targetWaitMs.load())) {
+        // Demand outran the idle connections: keep that many more ready
+        // from now on, prewarm() opens them right after this
+        target += std::max({ 1, waiting, static_cast<int>(std::min<uint64_t>(slowAcquires, DB_POOL_CAPACITY_LIMIT)) });
+        m_calmTime = std::chrono::milliseconds(0);
+        m_calmLowWater = std::numeric_limits<int>::max();
+    } else if (slowAcquires == 0) {
+        m_calmTime += elapsed;
+        m_calmLowWater = std::min(m_calmLowWater, lowWater);
+        if (m_calmTime >= std::chrono::seconds(m_shrinkDelay.load())) {
+            // At least m_calmLowWater idle connections were never touched
+            // during the whole calm period; give back half of them at a time
+            int surplus = (m_calmLowWater + 1) / 2;
+            int closable = std::min(surplus, m_idleCount.load() - minSize);
+            if (closable > 0) {
+                closeIdle(closable);
             }
+            target -= surplus;
+            m_calmTime = std::chrono::milliseconds(0);
+            m_calmLowWater = std::numeric_limits<int>::max();
+        }
+    } else {
+        // Some acquires waited briefly, within the target: hold steady
+        m_calmTime = std::chrono::milliseconds(0);
+        m_calmLowWater = std::numeric_limits<int>::max();
+    }
+    
+    m_targetIdle = std::clamp(target, minSize, m_maxSize.load());
+}
+
+void DBConnectionPool::prewarm() {
+    // Opened here, never on a requesting thread; each push wakes one waiter
+    while (m_running && m_idleCount < m_targetIdle + m_waitingThreads && reserveSlot()) {
+        auto conn = createConnection();
+        if (!conn) {
+            break; // Create failed, retry on the next run
+        }
+        pushIdle(conn);
+    }
+}
+
+void DBConnectionPool::evictIdle() {
+    auto now = std::chrono::steady_clock::now();
+    int maxIdleTime = m_maxIdleTime.load();
+    
+    // Check idle connections
+    int count = m_idleCount.load();
+    for (int i = 0; i < count && m_running; ++i) {
+        ConnectionWrapper* conn = nullptr;
+        if (!m_idleConnections->TryPop(conn)) {
+            break;
         }
+        --m_idleCount;
         
-        // Restore remaining connections
-        m_idleConnections = std::move(tempQueue);
+        auto idleTime = std::chrono::duration_cast<std::chrono::seconds>(
+            now - conn->getLastAccessTime()).count();
         
-        // If idle connections are less than minimum value, create new connection
-        while (m_idleConnections.size() < m_config.minSize && 
-               m_allConnections.size() < m_config.maxSize) {
-            auto conn = createConnection();
-            if (conn) {
-                m_idleConnections.push(conn);
-                m_allConnections.push_back(conn);
-            } else {
-                break; // Create failed, stop trying
-            }
+        // If idle time exceeds maximum value and idle connections stay at or above target, close
+        if (idleTime > maxIdleTime && m_idleCount >= m_targetIdle) {
+            closeConnection(conn);
+        } else {
+            pushIdle(conn);
         }
     }
 }
 
+int DBConnectionPool::closeIdle(int count) {
+    int closed = 0;
+    ConnectionWrapper* conn = nullptr;
+    while (closed < count && m_idleConnections->TryPop(conn)) {
+        --m_idleCount;
+        closeConnection(conn);
+        ++closed;
+    }
+    return closed;
+}
+
 void DBConnectionPool::closeConnection(ConnectionWrapper* conn) {
     if (!conn) return;
     
-    // Remove from all connections
-    auto it = std::find(m_allConnections.begin(), m_allConnections.end(), conn);
-    if (it != m_allConnections.end()) {
-        m_allConnections.erase(it);
+    {
+        std::lock_guard<std::mutex> lock(m_registryMutex);
+        m_allConnections.erase(conn);
     }
     
-    // Remove from active connections
-    m_activeConnections.erase(conn);
-    
     delete conn;
+    --m_totalConnections;
+    // The freed slot is refilled by the manager thread if anyone is waiting
+    if (m_waitingThreads > 0) {
+        requestGrowth();
+    }
 }
 
 DBConnectionPool::PoolStats DBConnectionPool::getStats() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
     PoolStats stats;
-    stats.totalConnections = m_allConnections.size();
-    stats.activeConnections = m_activeConnections.size();
-    stats.idleConnections = m_idleConnections.size();
+    stats.totalConnections = m_totalConnections.load();
+    stats.activeConnections = m_activeConnections.load();
+    stats.idleConnections = m_idleCount.load();
     stats.waitingThreads = m_waitingThreads.load();
+    stats.maxSize = m_maxSize.load();
+    stats.targetIdle = m_targetIdle.load();
     
     return stats;
 }
 
 DBConnectionPool::~DBConnectionPool() {
     shutdown();
-} 
\ No newline at end of file
+}
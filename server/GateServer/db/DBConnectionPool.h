@@ -1,13 +1,16 @@
 #pragma once
 #include "../const.h"
+#include "../MPMCQueue.h"
 #include <mysql/jdbc.h>
 #include <memory>
 #include <mutex>
 #include <iostream>
 #include <atomic>
 #include <vector>
-#include <queue>
+#include <condition_variable>
 #include <unordered_set>
+#include <unordered_map>
+#include <list>
 #include <thread>
 #include <chrono>
 #include <functional>
@@ -16,11 +19,15 @@
 // 连接包装类
 class ConnectionWrapper {
 public:
-    ConnectionWrapper(sql::Connection* conn, int id)
+    ConnectionWrapper(sql::Connection* conn, int id, size_t statementCacheSize = DB_DEFAULT_STATEMENT_CACHE_SIZE)
         : m_connection(conn), m_id(id), m_state(ConnectionState::IDLE),
-          m_lastAccessTime(std::chrono::steady_clock::now()) {}
+          m_lastAccessTime(std::chrono::steady_clock::now()),
+          m_lastValidTime(m_lastAccessTime),
+          m_statementCacheSize(statementCacheSize) {}
     
     ~ConnectionWrapper() {
+        // 预处理语句必须在连接关闭前释放
+        clearStatementCache();
         if (m_connection) {
             try {
                 m_connection->close();
@@ -49,6 +56,41 @@ public:
         m_lastAccessTime = std::chrono::steady_clock::now();
     }
     
+    // 最近一次确认连接可用的时间：被使用过或心跳检查通过
+    std::chrono::steady_clock::time_point getLastValidTime() const {
+        return std::max(m_lastAccessTime, m_lastValidTime);
+    }
+    
+    // 获取预处理语句：按SQL缓存在本连接上，跨多次借出复用，超过容量按LRU淘汰。
+    // 连接同一时间只被一个线程持有，缓存不需要加锁。
+    std::shared_ptr<sql::PreparedStatement> prepareCached(const std::string& sql) {
+        auto it = m_statementIndex.find(sql);
+        if (it != m_statementIndex.end()) {
+            m_statements.splice(m_statements.begin(), m_statements, it->second);
+            auto stmt = it->second->second;
+            stmt->clearParameters();
+            return stmt;
+        }
+        
+        std::shared_ptr<sql::PreparedStatement> stmt(m_connection->prepareStatement(sql));
+        if (m_statementCacheSize == 0) {
+            return stmt;
+        }
+        m_statements.emplace_front(sql, stmt);
+        m_statementIndex[sql] = m_statements.begin();
+        if (m_statements.size() > m_statementCacheSize) {
+            m_statementIndex.erase(m_statements.back().first);
+            m_statements.pop_back();
+        }
+        return stmt;
+    }
+    
+    // 释放缓存的预处理语句，连接被回收或重建时调用
+    void clearStatementCache() {
+        m_statementIndex.clear();
+        m_statements.clear();
+    }
+    
     // 心跳检测
     bool ping() {
         try {
@@ -59,7 +101,11 @@ public:
             // 执行一个简单的查询来测试连接
             std::unique_ptr<sql::Statement> stmt(m_connection->createStatement());
             std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery("SELECT 1"));
-            return rs->next() && rs->getInt(1) == 1;
+            bool ok = rs->next() && rs->getInt(1) == 1;
+            if (ok) {
+                m_lastValidTime = std::chrono::steady_clock::now();
+            }
+            return ok;
         } catch (...) {
             return false;
         }
@@ -70,6 +116,12 @@ private:
     int m_id;
     ConnectionState m_state;
     std::chrono::steady_clock::time_point m_lastAccessTime;
+    std::chrono::steady_clock::time_point m_lastValidTime;
+    
+    // 预处理语句缓存(LRU)
+    size_t m_statementCacheSize;
+    std::list<std::pair<std::string, std::shared_ptr<sql::PreparedStatement>>> m_statements;
+    std::unordered_map<std::string, std::list<std::pair<std::string, std::shared_ptr<sql::PreparedStatement>>>::iterator> m_statementIndex;
 };
 
 // 连接池配置
@@ -84,8 +136,12 @@ struct DBPoolConfig {
     int maxIdleTime;            // 连接最大空闲时间(秒)
     int connectionTimeout;      // 获取连接超时时间(秒)
     int validationInterval;     // 连接有效性检查间隔(秒)
+    int validationWindow;       // 连接在这段时间(秒)内确认可用过则借出时不再ping，0表示每次都ping
     int timeBetweenEvictionRuns;// 空闲连接清理间隔(秒)
     int maxWaitQueueSize;       // 最大等待队列大小
+    int statementCacheSize;     // 每个连接缓存的预处理语句数，0表示不缓存
+    int targetWaitMs;           // 借连接的平均等待超过该值(毫秒)时提前扩容
+    int shrinkDelay;            // 持续这么多秒没有等待、且有空闲连接一直没被用到时缩容
     
     // 默认构造函数 - 使用默认值初始化
     DBPoolConfig()
@@ -95,11 +151,18 @@ struct DBPoolConfig {
           maxIdleTime(DB_DEFAULT_MAX_IDLE_TIME),
           connectionTimeout(DB_DEFAULT_TIMEOUT),
           validationInterval(DB_DEFAULT_VALIDATION_INTERVAL),
+          validationWindow(DB_DEFAULT_VALIDATION_WINDOW),
           timeBetweenEvictionRuns(DB_DEFAULT_EVICTION_INTERVAL),
-          maxWaitQueueSize(DB_DEFAULT_MAX_WAIT_QUEUE_SIZE) {}
+          maxWaitQueueSize(DB_DEFAULT_MAX_WAIT_QUEUE_SIZE),
+          statementCacheSize(DB_DEFAULT_STATEMENT_CACHE_SIZE),
+          targetWaitMs(DB_DEFAULT_TARGET_WAIT_MS),
+          shrinkDelay(DB_DEFAULT_SHRINK_DELAY) {}
 };
 
 // 数据库连接池类
+// 连接只在维护线程上建立：空闲连接不够时借连接的线程只负责通知维护线程并等待，
+// 维护线程根据等待线程数和借连接的等待时间调整空闲连接目标数并提前预热，
+// 空闲连接长时间用不到时逐步回收，最少保留minSize个。
 class DBConnectionPool {
 public:
     // 构造函数
@@ -109,22 +172,32 @@ public:
     // 初始化连接池
     bool init(const DBPoolConfig& config);
     
-    // 获取连接
-    std::shared_ptr<ConnectionWrapper> getConnection(int timeoutSeconds = 0);
+    // 获取连接，validate为true时不管validationWindow，借出前一定ping一次
+    std::shared_ptr<ConnectionWrapper> getConnection(int timeoutSeconds = 0, bool validate = false);
     
     // 关闭连接池
     void shutdown();
     
+    // 运行时更新连接数上下限、超时、扩缩容等参数，连接地址、账号和语句缓存大小不变
+    void reconfigure(const DBPoolConfig& config);
+    
     // 获取连接池状态信息
     struct PoolStats {
         int totalConnections;
         int activeConnections;
         int idleConnections;
         int waitingThreads;
+        int maxSize;
+        int targetIdle;             // 当前的空闲连接目标数
     };
     
     PoolStats getStats() const;
     
+    // 未完成的请求数(借出的连接+等待中的线程)，用于在多个连接池之间分配请求
+    int outstanding() const {
+        return m_activeConnections.load(std::memory_order_relaxed) + m_waitingThreads.load(std::memory_order_relaxed);
+    }
+    
     // 回调函数类型定义
     using ConnectionEventCallback = std::function<void(ConnectionWrapper*)>;
     
@@ -144,47 +217,119 @@ public:
     }
     
 private:
-    // 创建新连接
+    // 创建新连接并登记，在锁外执行(TCP握手+认证)；调用前必须已经通过reserveSlot预留名额
     ConnectionWrapper* createConnection();
     
+    // 预留一个连接名额，总连接数(含正在建立的)不超过maxSize
+    bool reserveSlot();
+    
     // 检查连接有效性
     bool validateConnection(ConnectionWrapper* conn);
     
+    // 连接超出validationWindow没有确认过可用时才需要ping
+    bool needsValidation(ConnectionWrapper* conn) const;
+    
     // 心跳检测线程函数
     void heartbeatChecker();
     
     // 连接池维护线程函数
     void connectionManager();
     
+    // 维护线程的可中断等待，返回false表示连接池已关闭
+    bool sleepFor(std::chrono::seconds duration);
+    
+    // 维护线程等待下一个周期，有借连接的线程在等待时提前唤醒
+    bool waitForWork(std::chrono::milliseconds duration);
+    
+    // 通知维护线程尽快补充连接
+    void requestGrowth();
+    
+    // 根据上一周期的等待情况调整空闲连接目标数，持续空闲时回收多余连接
+    void adjustTarget(std::chrono::milliseconds elapsed);
+    
+    // 建立连接直到空闲连接数达到目标(加上正在等待的线程数)
+    void prewarm();
+    
+    // 关闭超过maxIdleTime的空闲连接，空闲连接数不低于目标数
+    void evictIdle();
+    
+    // 关闭最多count个空闲连接，返回实际关闭的数量
+    int closeIdle(int count);
+    
+    // 保存运行时可调整的参数
+    void applyConfig(const DBPoolConfig& config);
+    
+    // 记录借出后剩余的空闲连接数，用于判断哪些空闲连接一直没被用到
+    void recordIdleLowWater(int idle);
+    
+    // 记录一次需要等待的借出
+    void recordWait(std::chrono::steady_clock::time_point waitStart);
+    
     // 标记连接为可用
     void releaseConnection(ConnectionWrapper* conn);
     
-    // 关闭并移除连接
+    // 放回空闲队列并唤醒等待者
+    void pushIdle(ConnectionWrapper* conn);
+    
+    // 包装成借出的智能指针
+    std::shared_ptr<ConnectionWrapper> lend(ConnectionWrapper* conn);
+    
+    // 关闭并移除连接，O(1)
     void closeConnection(ConnectionWrapper* conn);
     
-    // 配置
+    // 有连接放回空闲队列时唤醒一个等待者
+    void notifyWaiter();
+    
+    // 配置，连接地址、账号、语句缓存大小等初始化后不再变化
     DBPoolConfig m_config;
     
-    // 连接管理
-    std::vector<ConnectionWrapper*> m_allConnections;
-    std::queue<ConnectionWrapper*> m_idleConnections;
-    std::unordered_set<ConnectionWrapper*> m_activeConnections;
+    // 运行时可调整的参数，reconfigure时更新
+    std::atomic<int> m_maxSize{DB_DEFAULT_MAX_SIZE};
+    std::atomic<int> m_minSize{DB_DEFAULT_MIN_SIZE};
+    std::atomic<int> m_maxIdleTime{DB_DEFAULT_MAX_IDLE_TIME};
+    std::atomic<int> m_connectionTimeout{DB_DEFAULT_TIMEOUT};
+    std::atomic<int> m_validationInterval{DB_DEFAULT_VALIDATION_INTERVAL};
+    std::atomic<int> m_validationWindow{DB_DEFAULT_VALIDATION_WINDOW};
+    std::atomic<int> m_evictionInterval{DB_DEFAULT_EVICTION_INTERVAL};
+    std::atomic<int> m_targetWaitMs{DB_DEFAULT_TARGET_WAIT_MS};
+    std::atomic<int> m_shrinkDelay{DB_DEFAULT_SHRINK_DELAY};
+    
+    // 扩缩容控制
+    std::atomic<int> m_targetIdle{DB_DEFAULT_MIN_SIZE};  // 空闲连接目标数，不小于minSize
+    std::atomic<bool> m_growRequested{false};
+    std::atomic<int> m_idleLowWater{0};                 // 本周期内空闲连接数的最低值
+    std::atomic<uint64_t> m_slowAcquires{0};            // 本周期内需要等待的借出次数
+    std::atomic<uint64_t> m_slowWaitUs{0};              // 本周期内这些借出的总等待时间
+    std::chrono::milliseconds m_calmTime{0};            // 连续没有等待的时长，只在维护线程上访问
+    int m_calmLowWater{0};                              // 这段时间内空闲连接数的最低值
+    
+    // 空闲连接，无锁队列，借出和归还都不加锁
+    std::unique_ptr<MPMCQueue<ConnectionWrapper*>> m_idleConnections;
+    
+    // 所有连接的登记表，只在建立和销毁连接时加m_registryMutex
+    std::unordered_set<ConnectionWrapper*> m_allConnections;
+    mutable std::mutex m_registryMutex;
     
-    // 线程同步
-    mutable std::mutex m_mutex;
+    // 连接计数
+    std::atomic<int> m_totalConnections{0};   // 含正在建立中的连接
+    std::atomic<int> m_idleCount{0};
+    std::atomic<int> m_activeConnections{0};
+    std::atomic<int> m_nextConnectionId{0};
+    
+    // 只在没有空闲连接、需要等待时使用
+    std::mutex m_mutex;
     std::condition_variable m_condition;
     
     // 维护线程
     std::thread m_heartbeatThread;
     std::thread m_managerThread;
+    std::mutex m_stopMutex;
+    std::condition_variable m_stopCondition;
     
     // 状态标志
     std::atomic<bool> m_running{false};
     std::atomic<int> m_waitingThreads{0};
     
-    // 连接计数
-    int m_nextConnectionId{0};
-    
     // 回调函数
     ConnectionEventCallback m_onConnectionCreate;
     ConnectionEventCallback m_onConnectionAcquire;
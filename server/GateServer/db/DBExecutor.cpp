@@ -0,0 +1,62 @@
+#include "DBExecutor.h"
+#include "DBManager.h"
+#include "../ConfigMgr.h"
+#include <algorithm>
+
+namespace {
+    int readConfig(const char* key, int defaultValue) {
+        auto value = ConfigMgr::Inst()[DB_EXECUTOR_CONFIG_SECTION][key];
+        int result = value.empty() ? 0 : atoi(value.c_str());
+        return result > 0 ? result : defaultValue;
+    }
+
+    // More workers than pooled connections would only move the wait into the pool
+    size_t workerCount() {
+        auto maxSize = ConfigMgr::Inst()[MYSQL_CONFIG_SECTION][MYSQL_MAX_SIZE_KEY];
+        int poolSize = maxSize.empty() ? DB_DEFAULT_MAX_SIZE : std::max(atoi(maxSize.c_str()), 1);
+        return std::min(readConfig(DB_EXECUTOR_THREADS_KEY, DB_EXECUTOR_DEFAULT_THREADS), poolSize);
+    }
+}
+
+DBExecutor::DBExecutor()
+    : m_capacity(workerCount() + readConfig(DB_EXECUTOR_QUEUE_SIZE_KEY, DB_EXECUTOR_DEFAULT_QUEUE_SIZE)),
+      m_pool(workerCount()) {
+    // Drain in-flight queries before the pool closes their connections
+    gDBManager.addShutdownHook([this]() { stop(); });
+}
+
+DBExecutor::~DBExecutor() {
+    stop();
+}
+
+bool DBExecutor::tryAcquire() {
+    if (m_stopped.load(std::memory_order_relaxed)) {
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    size_t pending = m_pending.load(std::memory_order_relaxed);
+    do {
+        if (pending >= m_capacity) {
+            m_rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!m_pending.compare_exchange_weak(pending, pending + 1, std::memory_order_relaxed));
+    m_submitted.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void DBExecutor::stop() {
+    if (m_stopped.exchange(true)) {
+        return;
+    }
+    // join() waits for every task already posted, stop() would drop queued ones
+    m_pool.join();
+}
+
+DBExecutorStats DBExecutor::getStats() const {
+    DBExecutorStats stats;
+    stats.submitted = m_submitted.load(std::memory_order_relaxed);
+    stats.rejected = m_rejected.load(std::memory_order_relaxed);
+    stats.pending = m_pending.load(std::memory_order_relaxed);
+    return stats;
+}
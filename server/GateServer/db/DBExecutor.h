@@ -0,0 +1,62 @@
+#pragma once
+#include "../const.h"
+#include "../Singleton.h"
+#include <atomic>
+#include <optional>
+#include <type_traits>
+
+// 数据库执行器统计
+struct DBExecutorStats {
+    uint64_t submitted;     // 接受的任务数
+    uint64_t rejected;      // 队列已满被拒绝的任务数
+    uint64_t pending;       // 当前排队和执行中的任务数
+};
+
+// 数据库专用的有界线程池。
+// 线程数不超过连接池上限，每个线程同一时刻最多占用一个连接，不会在连接池上排队；
+// 排队和执行中的任务总数有上限，超过上限时TryRun立即返回空，由调用方返回"繁忙"，
+// 而不是让请求阻塞在连接池上等待30秒。
+class DBExecutor : public Singleton<DBExecutor> {
+    friend class Singleton<DBExecutor>;
+public:
+    ~DBExecutor();
+
+    // 在数据库线程上执行func，协程在完成后回到原来的executor上继续运行
+    // 队列已满时返回std::nullopt，func不会被执行
+    template <typename Func>
+    net::awaitable<std::optional<std::invoke_result_t<Func>>> TryRun(Func func) {
+        using Result = std::invoke_result_t<Func>;
+        if (!tryAcquire()) {
+            co_return std::nullopt;
+        }
+        co_return co_await net::co_spawn(m_pool.get_executor(),
+            [this, func = std::move(func)]() mutable -> net::awaitable<std::optional<Result>> {
+                PendingGuard guard(this);
+                co_return func();
+            },
+            net::use_awaitable);
+    }
+
+    // 等待已提交的任务执行完并停止线程
+    void stop();
+
+    DBExecutorStats getStats() const;
+
+private:
+    struct PendingGuard {
+        explicit PendingGuard(DBExecutor* executor) : m_executor(executor) {}
+        ~PendingGuard() { m_executor->m_pending.fetch_sub(1, std::memory_order_relaxed); }
+        DBExecutor* m_executor;
+    };
+
+    DBExecutor();
+    bool tryAcquire();
+
+    size_t m_capacity;
+    net::thread_pool m_pool;
+    std::atomic<size_t> m_pending{ 0 };
+    std::atomic<bool> m_stopped{ false };
+
+    std::atomic<uint64_t> m_submitted{ 0 };
+    std::atomic<uint64_t> m_rejected{ 0 };
+};
@@ -1,12 +1,19 @@
 #pragma once
 #include "DBConnectionPool.h"
+#include "ReplicaSet.h"
 #include "../const.h"
 #include <iostream>
 #include <memory>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <vector>
 
 /**
  * Database Manager Class
- * Provides initialization and management of database-related functionality
+ * Provides initialization and management of database-related functionality.
+ * Owns the primary pool and, when [Mysql] Replicas lists any hosts, a set of
+ * read-only replica pools used by getReadConnection.
  */
 class DBManager {
 public:
@@ -31,45 +38,18 @@ public:
         }
         
         try {
-            // Build database configuration
+            // Build database configuration from the config file
             DBPoolConfig config;
-            
-            // Read database connection information from config file
-            config.host = ConfigMgr::Inst()[MYSQL_CONFIG_SECTION][MYSQL_HOST_KEY];
-            config.user = ConfigMgr::Inst()[MYSQL_CONFIG_SECTION][MYSQL_USER_KEY];
-            config.password = ConfigMgr::Inst()[MYSQL_CONFIG_SECTION][MYSQL_PASSWD_KEY];
-            config.database = ConfigMgr::Inst()[MYSQL_CONFIG_SECTION][MYSQL_SCHEMA_KEY];
-            
-            // Convert port to integer
-            std::string portStr = ConfigMgr::Inst()[MYSQL_CONFIG_SECTION][MYSQL_PORT_KEY];
-            if (portStr.empty()) {
-                portStr = "3306"; // Default port
-            }
-            
-            try {
-                int port = std::stoi(portStr);
-                // Add port number to host address
-                config.host += ":" + portStr;
-            } catch (const std::exception& e) {
-                std::cerr << "Database port configuration error: " << e.what() << std::endl;
+            if (!loadPoolConfig(config)) {
                 return false;
             }
             
-            // Initialize other configs with default values
-            config.initialSize = DB_DEFAULT_INITIAL_SIZE;
-            config.maxSize = DB_DEFAULT_MAX_SIZE;
-            config.minSize = DB_DEFAULT_MIN_SIZE;
-            config.maxIdleTime = DB_DEFAULT_MAX_IDLE_TIME;
-            config.connectionTimeout = DB_DEFAULT_TIMEOUT;
-            config.validationInterval = DB_DEFAULT_VALIDATION_INTERVAL;
-            config.timeBetweenEvictionRuns = DB_DEFAULT_EVICTION_INTERVAL;
-            config.maxWaitQueueSize = DB_DEFAULT_MAX_WAIT_QUEUE_SIZE;
-            
             // Create and initialize connection pool
             m_connectionPool = std::make_shared<DBConnectionPool>();
             if (m_connectionPool && m_connectionPool->init(config)) {
                 std::cout << "Database connection pool initialized successfully" << std::endl;
                 m_initialized = true;
+                initReplicas(config);
                 return true;
             } else {
                 std::cerr << "Failed to initialize database connection pool" << std::endl;
@@ -81,23 +61,90 @@ public:
         }
     }
     
+    /**
+     * Re-read config.ini and apply the pool sizing and timeout parameters
+     * to the running pool; host, account and schema changes need a restart
+     * 
+     * @return Whether the new configuration was applied
+     */
+    bool reloadPoolConfig() {
+        if (!m_connectionPool || !m_initialized) {
+            return false;
+        }
+        if (!ConfigMgr::Inst().Reload()) {
+            return false;
+        }
+        DBPoolConfig config;
+        if (!loadPoolConfig(config)) {
+            return false;
+        }
+        m_connectionPool->reconfigure(config);
+        if (m_replicas) {
+            m_replicas->reconfigure(config, readMaxReplicaLag());
+        }
+        std::cout << "Database connection pool config reloaded: min " << config.minSize
+                  << ", max " << config.maxSize << std::endl;
+        return true;
+    }
+    
     /**
      * Get a database connection
      * @param timeoutSeconds Timeout in seconds when obtaining a connection, 0 means use default timeout
+     * @param validate Ping the connection before lending it even if it was used recently
      * @return Smart pointer to a connection wrapper
      */
-    std::shared_ptr<ConnectionWrapper> getConnection(int timeoutSeconds = 0) {
+    std::shared_ptr<ConnectionWrapper> getConnection(int timeoutSeconds = 0, bool validate = false) {
         if (!m_connectionPool || !m_initialized) {
             throw std::runtime_error("Database connection pool not initialized");
         }
-        return m_connectionPool->getConnection(timeoutSeconds);
+        return m_connectionPool->getConnection(timeoutSeconds, validate);
+    }
+    
+    /**
+     * Get a connection for a read that tolerates replication lag.
+     * Goes to the least busy in-sync replica, or to the primary when no
+     * replica is configured or available.
+     */
+    std::shared_ptr<ConnectionWrapper> getReadConnection(int timeoutSeconds = 0, bool validate = false) {
+        if (m_replicas) {
+            if (auto conn = m_replicas->getConnection(timeoutSeconds, validate)) {
+                return conn;
+            }
+        }
+        return getConnection(timeoutSeconds, validate);
+    }
+    
+    /**
+     * Register a hook that runs before the pool is shut down,
+     * e.g. to flush deferred writes while connections are still available
+     */
+    void addShutdownHook(std::function<void()> hook) {
+        std::lock_guard<std::mutex> lock(m_hookMutex);
+        m_shutdownHooks.push_back(std::move(hook));
     }
     
     /**
      * Shutdown the database connection pool
      */
     void shutdownDBConnectionPool() {
+        // Run hooks in reverse registration order before connections go away
+        std::vector<std::function<void()>> hooks;
+        {
+            std::lock_guard<std::mutex> lock(m_hookMutex);
+            hooks.swap(m_shutdownHooks);
+        }
+        for (auto it = hooks.rbegin(); it != hooks.rend(); ++it) {
+            try {
+                (*it)();
+            } catch (const std::exception& e) {
+                std::cerr << "Exception in database shutdown hook: " << e.what() << std::endl;
+            }
+        }
+        
         try {
+            if (m_replicas) {
+                m_replicas->shutdown();
+            }
             if (m_connectionPool) {
                 m_connectionPool->shutdown();
                 std::cout << "Database connection pool has been closed" << std::endl;
@@ -109,15 +156,34 @@ public:
     }
     
     /**
-     * Get connection pool statistics
+     * Get connection pool statistics; all zero when the pool is not initialized
+     * (or already shut down), so monitoring never fails on it
      */
     DBConnectionPool::PoolStats getPoolStats() const {
         if (!m_connectionPool || !m_initialized) {
-            throw std::runtime_error("Database connection pool not initialized");
+            return DBConnectionPool::PoolStats{ 0, 0, 0, 0, 0, 0 };
         }
         return m_connectionPool->getStats();
     }
     
+    /**
+     * Get replica routing statistics; all zero when no replica is configured
+     */
+    ReplicaStats getReplicaStats() const {
+        if (!m_replicas) {
+            return ReplicaStats{ 0, 0, 0, 0 };
+        }
+        return m_replicas->getStats();
+    }
+    
+    /**
+     * Upper bound in seconds on how far a replica read can lag the primary;
+     * 0 when no replica is configured
+     */
+    int getReplicaLagBound() const {
+        return m_replicas ? m_replicas->lagBound() : 0;
+    }
+    
     /**
      * Check if the database connection pool is initialized
      */
@@ -126,6 +192,87 @@ public:
     }
     
 private:
+    /**
+     * Read the [Mysql] section; missing or invalid values fall back to the DB_DEFAULT_* constants
+     */
+    static bool loadPoolConfig(DBPoolConfig& config) {
+        auto section = ConfigMgr::Inst()[MYSQL_CONFIG_SECTION];
+        auto readInt = [&section](const char* key, int defaultValue) {
+            std::string value = section[key];
+            return value.empty() ? defaultValue : atoi(value.c_str());
+        };
+        
+        // Read database connection information from config file
+        config.host = section[MYSQL_HOST_KEY];
+        config.user = section[MYSQL_USER_KEY];
+        config.password = section[MYSQL_PASSWD_KEY];
+        config.database = section[MYSQL_SCHEMA_KEY];
+        
+        // Convert port to integer
+        std::string portStr = section[MYSQL_PORT_KEY];
+        if (portStr.empty()) {
+            portStr = "3306"; // Default port
+        }
+        
+        try {
+            int port = std::stoi(portStr);
+            // Add port number to host address
+            config.host += ":" + portStr;
+        } catch (const std::exception& e) {
+            std::cerr << "Database port configuration error: " << e.what() << std::endl;
+            return false;
+        }
+        
+        config.initialSize = readInt(MYSQL_INITIAL_SIZE_KEY, DB_DEFAULT_INITIAL_SIZE);
+        config.maxSize = readInt(MYSQL_MAX_SIZE_KEY, DB_DEFAULT_MAX_SIZE);
+        config.minSize = readInt(MYSQL_MIN_SIZE_KEY, DB_DEFAULT_MIN_SIZE);
+        config.maxIdleTime = readInt(MYSQL_MAX_IDLE_TIME_KEY, DB_DEFAULT_MAX_IDLE_TIME);
+        config.connectionTimeout = readInt(MYSQL_CONNECTION_TIMEOUT_KEY, DB_DEFAULT_TIMEOUT);
+        config.validationInterval = readInt(MYSQL_VALIDATION_INTERVAL_KEY, DB_DEFAULT_VALIDATION_INTERVAL);
+        config.validationWindow = readInt(MYSQL_VALIDATION_WINDOW_KEY, DB_DEFAULT_VALIDATION_WINDOW);
+        config.timeBetweenEvictionRuns = readInt(MYSQL_EVICTION_INTERVAL_KEY, DB_DEFAULT_EVICTION_INTERVAL);
+        config.maxWaitQueueSize = DB_DEFAULT_MAX_WAIT_QUEUE_SIZE;
+        config.statementCacheSize = readInt(MYSQL_STATEMENT_CACHE_SIZE_KEY, DB_DEFAULT_STATEMENT_CACHE_SIZE);
+        config.targetWaitMs = readInt(MYSQL_TARGET_WAIT_KEY, DB_DEFAULT_TARGET_WAIT_MS);
+        config.shrinkDelay = readInt(MYSQL_SHRINK_DELAY_KEY, DB_DEFAULT_SHRINK_DELAY);
+        return true;
+    }
+    
+    /**
+     * Create replica pools for the comma separated host:port list in [Mysql] Replicas.
+     * Replicas share the primary's account, schema and pool settings.
+     */
+    void initReplicas(const DBPoolConfig& primaryConfig) {
+        auto section = ConfigMgr::Inst()[MYSQL_CONFIG_SECTION];
+        std::vector<std::string> hosts;
+        std::stringstream ss(section[MYSQL_REPLICAS_KEY]);
+        std::string host;
+        while (std::getline(ss, host, ',')) {
+            host.erase(0, host.find_first_not_of(" \t"));
+            host.erase(host.find_last_not_of(" \t") + 1);
+            if (!host.empty()) {
+                hosts.push_back(host);
+            }
+        }
+        if (hosts.empty()) {
+            return;
+        }
+        
+        std::string intervalStr = section[MYSQL_REPLICA_CHECK_INTERVAL_KEY];
+        int checkInterval = intervalStr.empty() ? DB_DEFAULT_REPLICA_CHECK_INTERVAL : atoi(intervalStr.c_str());
+        auto replicas = std::make_unique<ReplicaSet>();
+        int count = replicas->init(hosts, primaryConfig, readMaxReplicaLag(), checkInterval);
+        std::cout << "Database replicas initialized: " << count << " of " << hosts.size() << std::endl;
+        if (count > 0) {
+            m_replicas = std::move(replicas);
+        }
+    }
+    
+    static int readMaxReplicaLag() {
+        std::string lagStr = ConfigMgr::Inst()[MYSQL_CONFIG_SECTION][MYSQL_MAX_REPLICA_LAG_KEY];
+        return lagStr.empty() ? DB_DEFAULT_MAX_REPLICA_LAG : atoi(lagStr.c_str());
+    }
+    
     // Private constructor - initialization now moved to initDBConnectionPool()
     DBManager() : m_initialized(false) {}
     
@@ -137,10 +284,15 @@ private:
     DBManager(const DBManager&) = delete;
     DBManager& operator=(const DBManager&) = delete;
     
-    // Database connection pool instance
+    // Database connection pool instance (primary, takes all writes)
     std::shared_ptr<DBConnectionPool> m_connectionPool;
+    // Read-only replica pools, null when none are configured
+    std::unique_ptr<ReplicaSet> m_replicas;
     // Flag to track initialization status
     bool m_initialized = false;
+    // Hooks run by shutdownDBConnectionPool before the pool closes
+    std::mutex m_hookMutex;
+    std::vector<std::function<void()>> m_shutdownHooks;
 };
 
 // Global DBManager instance access macro
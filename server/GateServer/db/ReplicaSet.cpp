@@ -0,0 +1,153 @@
+#include "ReplicaSet.h"
+
+int ReplicaSet::init(const std::vector<std::string>& hosts, const DBPoolConfig& config,
+                     int maxLag, int checkInterval) {
+    m_maxLag = maxLag;
+    m_checkInterval = std::max(checkInterval, 1);
+
+    for (const auto& host : hosts) {
+        DBPoolConfig replicaConfig = config;
+        replicaConfig.host = host;
+
+        auto replica = std::make_unique<Replica>();
+        replica->host = host;
+        replica->pool = std::make_shared<DBConnectionPool>();
+        if (!replica->pool->init(replicaConfig)) {
+            // A missing replica only costs read capacity, the primary still serves
+            std::cerr << "Failed to initialize replica pool for " << host << ", skipping" << std::endl;
+            continue;
+        }
+        m_replicas.push_back(std::move(replica));
+    }
+
+    if (!m_replicas.empty()) {
+        m_running = true;
+        m_monitorThread = std::thread(&ReplicaSet::lagMonitor, this);
+    }
+    return static_cast<int>(m_replicas.size());
+}
+
+std::shared_ptr<ConnectionWrapper> ReplicaSet::getConnection(int timeoutSeconds, bool validate) {
+    // Least outstanding requests: borrowed plus waiting connections per pool
+    Replica* best = nullptr;
+    int bestOutstanding = 0;
+    for (auto& replica : m_replicas) {
+        if (!replica->healthy.load(std::memory_order_relaxed)) {
+            continue;
+        }
+        int outstanding = replica->pool->outstanding();
+        if (!best || outstanding < bestOutstanding) {
+            best = replica.get();
+            bestOutstanding = outstanding;
+        }
+    }
+
+    if (best) {
+        try {
+            auto conn = best->pool->getConnection(timeoutSeconds, validate);
+            m_reads.fetch_add(1, std::memory_order_relaxed);
+            return conn;
+        } catch (const std::exception& e) {
+            std::cerr << "Replica " << best->host << " unavailable: " << e.what() << std::endl;
+        }
+    }
+    m_fallbacks.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+void ReplicaSet::reconfigure(const DBPoolConfig& config, int maxLag) {
+    m_maxLag = maxLag;
+    for (auto& replica : m_replicas) {
+        DBPoolConfig replicaConfig = config;
+        replicaConfig.host = replica->host;
+        replica->pool->reconfigure(replicaConfig);
+    }
+}
+
+void ReplicaSet::lagMonitor() {
+    while (true) {
+        for (auto& replica : m_replicas) {
+            if (!m_running) {
+                return;
+            }
+            int lag = queryLag(*replica);
+            bool healthy = lag >= 0 && lag <= m_maxLag;
+            replica->lag = lag;
+            if (replica->healthy.exchange(healthy) != healthy) {
+                std::cout << "Replica " << replica->host << (healthy ? " back in rotation" : " bypassed")
+                          << ", lag " << lag << "s" << std::endl;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(m_stopMutex);
+        if (m_stopCondition.wait_for(lock, std::chrono::seconds(m_checkInterval), [this] { return !m_running; })) {
+            return;
+        }
+    }
+}
+
+int ReplicaSet::queryLag(Replica& replica) {
+    try {
+        auto conn = replica.pool->getConnection(m_checkInterval);
+        std::unique_ptr<sql::Statement> stmt(conn->getConnection()->createStatement());
+        std::unique_ptr<sql::ResultSet> rs;
+        if (!replica.useLegacyStatus) {
+            try {
+                rs.reset(stmt->executeQuery("SHOW REPLICA STATUS"));
+            } catch (const sql::SQLException&) {
+                // Servers before 8.0.22 only know the old syntax
+                replica.useLegacyStatus = true;
+            }
+        }
+        if (replica.useLegacyStatus) {
+            rs.reset(stmt->executeQuery("SHOW SLAVE STATUS"));
+        }
+
+        if (!rs->next()) {
+            // Not a replication replica at all (e.g. a standalone test instance)
+            return 0;
+        }
+        const char* column = replica.useLegacyStatus ? "Seconds_Behind_Master" : "Seconds_Behind_Source";
+        if (rs->isNull(column)) {
+            // Replication threads stopped
+            return -1;
+        }
+        return rs->getInt(column);
+    } catch (const std::exception& e) {
+        std::cerr << "Replica " << replica.host << " lag check failed: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+void ReplicaSet::shutdown() {
+    if (m_running.exchange(false)) {
+        {
+            std::lock_guard<std::mutex> lock(m_stopMutex);
+            m_stopCondition.notify_all();
+        }
+        if (m_monitorThread.joinable()) {
+            m_monitorThread.join();
+        }
+    }
+    for (auto& replica : m_replicas) {
+        replica->pool->shutdown();
+    }
+}
+
+ReplicaStats ReplicaSet::getStats() const {
+    ReplicaStats stats;
+    stats.replicas = static_cast<int>(m_replicas.size());
+    stats.healthy = 0;
+    for (const auto& replica : m_replicas) {
+        if (replica->healthy.load(std::memory_order_relaxed)) {
+            ++stats.healthy;
+        }
+    }
+    stats.reads = m_reads.load(std::memory_order_relaxed);
+    stats.fallbacks = m_fallbacks.load(std::memory_order_relaxed);
+    return stats;
+}
+
+ReplicaSet::~ReplicaSet() {
+    shutdown();
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "DBConnectionPool.h"
+#include <string>
+
+// 只读副本统计
+struct ReplicaStats {
+    int replicas;           // 配置的副本数
+    int healthy;            // 当前可用(连接正常且延迟在允许范围内)的副本数
+    uint64_t reads;         // 分配到副本的读请求数
+    uint64_t fallbacks;     // 没有可用副本、退回主库的读请求数
+};
+
+// 一组只读副本的连接池。
+// 读请求分配给未完成请求(借出+等待)最少的可用副本；
+// 后台线程定期检查每个副本的复制延迟，延迟超过maxLag秒、复制中断或连接失败的副本暂时不参与分配，
+// 恢复后自动重新加入。没有可用副本时getConnection返回空，由调用方改用主库。
+class ReplicaSet {
+public:
+    ReplicaSet() = default;
+    ~ReplicaSet();
+
+    // 为每个副本地址(host:port)建立连接池，其余配置与主库相同。
+    // 单个副本初始化失败只跳过该副本，返回成功初始化的副本数
+    int init(const std::vector<std::string>& hosts, const DBPoolConfig& config,
+             int maxLag, int checkInterval);
+
+    // 从最空闲的可用副本借一个连接，没有可用副本或借连接失败时返回nullptr
+    std::shared_ptr<ConnectionWrapper> getConnection(int timeoutSeconds = 0, bool validate = false);
+
+    // 可用副本落后主库的上限(秒)：延迟超过maxLag最晚在下一次检查时被发现
+    int lagBound() const { return m_maxLag.load(std::memory_order_relaxed) + m_checkInterval; }
+
+    // 运行时更新各副本连接池的参数
+    void reconfigure(const DBPoolConfig& config, int maxLag);
+
+    void shutdown();
+
+    ReplicaStats getStats() const;
+
+private:
+    struct Replica {
+        std::string host;
+        std::shared_ptr<DBConnectionPool> pool;
+        std::atomic<bool> healthy{true};
+        std::atomic<int> lag{0};                // 最近一次检查到的复制延迟(秒)，-1表示未知
+        bool useLegacyStatus = false;           // 服务器不支持SHOW REPLICA STATUS时改用SHOW SLAVE STATUS
+    };
+
+    // 延迟检查线程函数
+    void lagMonitor();
+
+    // 查询副本的复制延迟(秒)；复制中断或查询失败返回-1；不是复制从库(没有复制状态)返回0
+    int queryLag(Replica& replica);
+
+    std::vector<std::unique_ptr<Replica>> m_replicas;
+    std::atomic<int> m_maxLag{0};
+    int m_checkInterval = 0;
+
+    std::thread m_monitorThread;
+    std::mutex m_stopMutex;
+    std::condition_variable m_stopCondition;
+    std::atomic<bool> m_running{false};
+
+    std::atomic<uint64_t> m_reads{0};
+    std::atomic<uint64_t> m_fallbacks{0};
+};
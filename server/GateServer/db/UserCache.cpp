@@ -0,0 +1,267 @@
+#include "UserCache.h"
+#include "../ConfigMgr.h"
+#include "../JsonCodec.h"
+
+namespace {
+    int readConfig(const char* key, int defaultValue) {
+        auto value = ConfigMgr::Inst()[USER_CACHE_CONFIG_SECTION][key];
+        int result = value.empty() ? 0 : atoi(value.c_str());
+        return result > 0 ? result : defaultValue;
+    }
+
+    std::string idKey(int64_t userId) {
+        return "user:id:" + std::to_string(userId);
+    }
+
+    std::string nameKey(const std::string& username) {
+        return "user:name:" + username;
+    }
+
+    // 原地替换Redis条目中的status字段，保留剩余的过期时间；条目不存在时返回0。
+    // 字符串值里的引号都被转义，"status":"只可能匹配到status字段本身
+    const char* PATCH_STATUS_SCRIPT =
+        "local v = redis.call('GET', KEYS[1]) "
+        "if not v then return 0 end "
+        "local patched, n = string.gsub(v, '\"status\":\"%a*\"', ARGV[1], 1) "
+        "if n == 0 then return 0 end "
+        "local ttl = redis.call('PTTL', KEYS[1]) "
+        "if ttl > 0 then redis.call('SET', KEYS[1], patched, 'PX', ttl) "
+        "else redis.call('SET', KEYS[1], patched) end "
+        "return 1";
+
+    // Redis中的资料用紧凑JSON保存，不包含密码
+    std::string serializeUser(const UserEntity& user) {
+        std::string out;
+        JsonWriter(out).BeginObject()
+            .Key("id").Int(user.userId)
+            .Key("username").String(user.username)
+            .Key("nickname").String(user.nickname)
+            .Key("avatar").String(user.avatar)
+            .Key("email").String(user.email)
+            .Key("status").String(userStatusName(user.status))
+            .Key("create_time").Int(user.createTime)
+            .Key("last_login_time").Int(user.lastLoginTime)
+            .EndObject();
+        return out;
+    }
+
+    // 时间是Unix时间戳；旧格式(时间为字符串)的条目解析失败，按未命中处理后被覆盖
+    bool parseUser(std::string_view json, UserEntity& user) {
+        JsonReader reader(json);
+        std::string text;
+        bool knownStatus = true;
+        return reader.ForEachField([&](std::string_view key) {
+            if (key == "id") reader.ReadInt(user.userId);
+            else if (key == "username") reader.ReadString(user.username);
+            else if (key == "nickname") reader.ReadString(user.nickname);
+            else if (key == "avatar") {
+                if (reader.ReadString(text)) {
+                    user.avatar = text;
+                }
+            }
+            else if (key == "email") reader.ReadString(user.email);
+            else if (key == "status") {
+                if (reader.ReadString(text)) {
+                    knownStatus = parseUserStatus(text, user.status);
+                }
+            }
+            else if (key == "create_time") reader.ReadInt(user.createTime);
+            else if (key == "last_login_time") reader.ReadInt(user.lastLoginTime);
+        }) && knownStatus;
+    }
+}
+
+UserCache::UserCache()
+    : m_users(readConfig(USER_CACHE_SHARDS_KEY, USER_CACHE_DEFAULT_SHARDS),
+              readConfig(USER_CACHE_CAPACITY_KEY, USER_CACHE_DEFAULT_CAPACITY),
+              std::chrono::seconds(readConfig(USER_CACHE_LOCAL_TTL_KEY, USER_CACHE_DEFAULT_LOCAL_TTL))),
+      m_usernames(readConfig(USER_CACHE_SHARDS_KEY, USER_CACHE_DEFAULT_SHARDS),
+                  readConfig(USER_CACHE_CAPACITY_KEY, USER_CACHE_DEFAULT_CAPACITY),
+                  std::chrono::seconds(readConfig(USER_CACHE_REDIS_TTL_KEY, USER_CACHE_DEFAULT_REDIS_TTL))),
+      m_friendIds(readConfig(USER_CACHE_SHARDS_KEY, USER_CACHE_DEFAULT_SHARDS),
+                  readConfig(USER_CACHE_CAPACITY_KEY, USER_CACHE_DEFAULT_CAPACITY),
+                  std::chrono::seconds(readConfig(USER_CACHE_LOCAL_TTL_KEY, USER_CACHE_DEFAULT_LOCAL_TTL))),
+      m_redisTtl(readConfig(USER_CACHE_REDIS_TTL_KEY, USER_CACHE_DEFAULT_REDIS_TTL)) {
+    m_patchStatus.source = PATCH_STATUS_SCRIPT;
+    m_patchStatus.sha = RedisMgr::GetInstance()->LoadScript(m_patchStatus.source);
+}
+
+std::shared_ptr<UserEntity> UserCache::getById(int64_t userId) {
+    std::shared_ptr<const UserEntity> cached;
+    if (m_users.Get(userId, cached)) {
+        m_localHits.fetch_add(1, std::memory_order_relaxed);
+        return std::make_shared<UserEntity>(*cached);
+    }
+
+    auto user = loadFromRedis(userId);
+    if (user) {
+        m_redisHits.fetch_add(1, std::memory_order_relaxed);
+        m_users.Put(userId, std::make_shared<const UserEntity>(*user));
+        return user;
+    }
+
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+std::shared_ptr<UserEntity> UserCache::getByUsername(const std::string& username) {
+    int64_t userId = 0;
+    if (m_usernames.Get(username, userId)) {
+        return getById(userId);
+    }
+
+    std::string idStr;
+    if (RedisMgr::GetInstance()->Get(nameKey(username), idStr)) {
+        userId = atoll(idStr.c_str());
+        if (userId > 0) {
+            m_usernames.Put(username, userId);
+            return getById(userId);
+        }
+    }
+
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+std::shared_ptr<UserEntity> UserCache::loadFromRedis(int64_t userId) {
+    std::string json;
+    if (!RedisMgr::GetInstance()->Get(idKey(userId), json)) {
+        return nullptr;
+    }
+    auto user = std::make_shared<UserEntity>();
+    if (!parseUser(json, *user) || user->userId != userId) {
+        return nullptr;
+    }
+    return user;
+}
+
+void UserCache::getMany(std::span<const int64_t> userIds, std::vector<std::shared_ptr<UserEntity>>& users) {
+    users.assign(userIds.size(), nullptr);
+
+    std::vector<size_t> remote;
+    for (size_t i = 0; i < userIds.size(); i++) {
+        std::shared_ptr<const UserEntity> cached;
+        if (m_users.Get(userIds[i], cached)) {
+            users[i] = std::make_shared<UserEntity>(*cached);
+        } else {
+            remote.push_back(i);
+        }
+    }
+    m_localHits.fetch_add(userIds.size() - remote.size(), std::memory_order_relaxed);
+    if (remote.empty()) {
+        return;
+    }
+
+    // 每条MGET限制key数量，所有MGET在一次往返中执行
+    RedisBatch batch;
+    std::vector<std::string> args;
+    for (size_t offset = 0; offset < remote.size(); offset += USER_CACHE_MGET_CHUNK_SIZE) {
+        size_t end = std::min(remote.size(), offset + USER_CACHE_MGET_CHUNK_SIZE);
+        args.clear();
+        args.push_back("MGET");
+        for (size_t k = offset; k < end; k++) {
+            args.push_back(idKey(userIds[remote[k]]));
+        }
+        batch.Add(args);
+    }
+
+    uint64_t redisHits = 0;
+    std::vector<RedisValue> replies;
+    if (RedisMgr::GetInstance()->Exec(batch, replies)) {
+        for (size_t chunk = 0; chunk < replies.size(); chunk++) {
+            size_t offset = chunk * USER_CACHE_MGET_CHUNK_SIZE;
+            auto& elements = replies[chunk].elements;
+            // 错误应答没有元素，这一批按未命中处理
+            if (elements.size() != std::min(remote.size() - offset, USER_CACHE_MGET_CHUNK_SIZE)) {
+                continue;
+            }
+            for (size_t k = 0; k < elements.size(); k++) {
+                size_t index = remote[offset + k];
+                auto& element = elements[k];
+                if (!element.IsString()) {
+                    continue;
+                }
+                auto user = std::make_shared<UserEntity>();
+                if (parseUser(element.str, *user) && user->userId == userIds[index]) {
+                    m_users.Put(user->userId, std::make_shared<const UserEntity>(*user));
+                    users[index] = std::move(user);
+                    redisHits++;
+                }
+            }
+        }
+    }
+    m_redisHits.fetch_add(redisHits, std::memory_order_relaxed);
+    m_misses.fetch_add(remote.size() - redisHits, std::memory_order_relaxed);
+}
+
+void UserCache::put(const UserEntity& user) {
+    putMany({ user });
+}
+
+void UserCache::putMany(const std::vector<UserEntity>& users) {
+    if (users.empty()) {
+        return;
+    }
+
+    // 资料和用户名映射在一次往返中写入
+    auto ttl = std::to_string(m_redisTtl);
+    RedisBatch batch;
+    for (auto& user : users) {
+        auto entry = std::make_shared<UserEntity>(user);
+        entry->password.clear();
+        m_users.Put(user.userId, std::move(entry));
+        m_usernames.Put(user.username, user.userId);
+
+        auto userIdStr = std::to_string(user.userId);
+        auto json = serializeUser(user);
+        auto userKey = idKey(user.userId);
+        auto usernameKey = nameKey(user.username);
+        batch.Add({ "SET", userKey, json, "EX", ttl })
+             .Add({ "SET", usernameKey, userIdStr, "EX", ttl });
+    }
+    std::vector<RedisValue> replies;
+    RedisMgr::GetInstance()->Exec(batch, replies);
+}
+
+void UserCache::invalidateUser(int64_t userId) {
+    m_users.Erase(userId);
+    RedisMgr::GetInstance()->Del(idKey(userId));
+}
+
+void UserCache::updateStatus(int64_t userId, UserStatus status) {
+    std::shared_ptr<const UserEntity> cached;
+    if (!m_users.Get(userId, cached)) {
+        // 不能删除Redis条目：写回落库之前的读穿会把数据库里的旧状态重新缓存
+        std::string field;
+        JsonWriter(field).Key("status").String(userStatusName(status));
+        RedisMgr::GetInstance()->EvalScript(m_patchStatus, { idKey(userId) }, { field });
+        return;
+    }
+    auto user = *cached;
+    user.status = status;
+    put(user);
+}
+
+std::shared_ptr<const std::vector<int64_t>> UserCache::getFriendIds(int64_t userId) {
+    std::shared_ptr<const std::vector<int64_t>> friendIds;
+    if (m_friendIds.Get(userId, friendIds)) {
+        return friendIds;
+    }
+    return nullptr;
+}
+
+void UserCache::putFriendIds(int64_t userId, std::vector<int64_t> friendIds) {
+    m_friendIds.Put(userId, std::make_shared<const std::vector<int64_t>>(std::move(friendIds)));
+}
+
+void UserCache::invalidateFriendIds(int64_t userId) {
+    m_friendIds.Erase(userId);
+}
+
+UserCacheStats UserCache::getStats() const {
+    return UserCacheStats{
+        m_localHits.load(std::memory_order_relaxed),
+        m_redisHits.load(std::memory_order_relaxed),
+        m_misses.load(std::memory_order_relaxed)
+    };
+}
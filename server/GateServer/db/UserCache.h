@@ -0,0 +1,67 @@
+#pragma once
+#include "UserDAO.h"
+#include "../Singleton.h"
+#include "../ShardedLruCache.h"
+#include "../RedisMgr.h"
+#include <atomic>
+#include <memory>
+#include <span>
+#include <vector>
+
+// 缓存命中统计
+struct UserCacheStats {
+    uint64_t localHits;   // 进程内LRU命中次数
+    uint64_t redisHits;   // 进程内未命中、Redis命中次数
+    uint64_t misses;      // 两级都未命中、需要查数据库的次数
+};
+
+// 用户资料的两级读穿缓存：进程内分片LRU + Redis，按userId和username索引。
+// 进程内条目有较短的过期时间，限制多个网关实例之间的不一致窗口。
+// 两级缓存都不保存密码，写入时清空。
+class UserCache : public Singleton<UserCache> {
+    friend class Singleton<UserCache>;
+public:
+    // 返回的是副本，调用方可以随意修改
+    std::shared_ptr<UserEntity> getById(int64_t userId);
+    std::shared_ptr<UserEntity> getByUsername(const std::string& username);
+
+    // 批量读取：users[i]对应userIds[i]，未命中为nullptr。
+    // 进程内未命中的id用MGET从Redis读取，所有MGET在一次往返中执行
+    void getMany(std::span<const int64_t> userIds, std::vector<std::shared_ptr<UserEntity>>& users);
+
+    // 写入两级缓存
+    void put(const UserEntity& user);
+    
+    // 批量写入，所有Redis写入在一次往返中执行
+    void putMany(const std::vector<UserEntity>& users);
+
+    // 资料变更后调用，删除两级缓存中的条目
+    void invalidateUser(int64_t userId);
+    
+    // 状态变更直接写入缓存；状态的落库是延迟的，失效缓存会让读穿读到旧状态。
+    // 进程内未命中时只改Redis条目中的status字段，Redis中也没有时不做任何事
+    void updateStatus(int64_t userId, UserStatus status);
+
+    // 好友id列表，只缓存在进程内
+    std::shared_ptr<const std::vector<int64_t>> getFriendIds(int64_t userId);
+    void putFriendIds(int64_t userId, std::vector<int64_t> friendIds);
+    void invalidateFriendIds(int64_t userId);
+
+    UserCacheStats getStats() const;
+
+private:
+    UserCache();
+
+    std::shared_ptr<UserEntity> loadFromRedis(int64_t userId);
+
+    ShardedLruCache<int64_t, std::shared_ptr<const UserEntity>> m_users;
+    // 用户名不会修改，username到userId的映射不需要失效
+    ShardedLruCache<std::string, int64_t> m_usernames;
+    ShardedLruCache<int64_t, std::shared_ptr<const std::vector<int64_t>>> m_friendIds;
+    int m_redisTtl;
+    RedisScript m_patchStatus;
+
+    std::atomic<uint64_t> m_localHits{ 0 };
+    std::atomic<uint64_t> m_redisHits{ 0 };
+    std::atomic<uint64_t> m_misses{ 0 };
+};
@@ -1,141 +1,274 @@
 #include "UserDAO.h"
 #include <sstream>
+#include <algorithm>
+#include <memory_resource>
+
+namespace {
+    // Column order of every result set decoded by buildUserFromResultSet; the
+    // user procedures return the same list, so rows are read by position
+    enum UserColumn {
+        COL_USER_ID = 1,
+        COL_USERNAME,
+        COL_PASSWORD,
+        COL_NICKNAME,
+        COL_AVATAR,
+        COL_EMAIL,
+        COL_STATUS,
+        COL_CREATE_TIME,
+        COL_LAST_LOGIN_TIME
+    };
+    
+    // Bulk lookups never return the password; an empty literal keeps the positions
+    const char* const BULK_USER_COLUMNS =
+        "user_id, username, '' AS password, nickname, avatar, email, status, "
+        "UNIX_TIMESTAMP(create_time), UNIX_TIMESTAMP(last_login_time)";
+    
+    // Keyset pages over the (user_id, friend_id) unique key; LIMIT is one more
+    // than the page size so the extra row tells whether another page follows
+    const char* const FRIEND_PAGE_SQL =
+        "SELECT u.user_id, u.username, u.nickname, u.avatar, u.status, f.deleted "
+        "FROM friendships f INNER JOIN users u ON u.user_id = f.friend_id "
+        "WHERE f.user_id = ? AND f.friend_id > ? AND f.deleted = 0 "
+        "ORDER BY f.friend_id LIMIT ?";
+
+    // Delta pages also return removed friendships so the client can drop them
+    const char* const FRIEND_DELTA_SQL =
+        "SELECT u.user_id, u.username, u.nickname, u.avatar, u.status, f.deleted "
+        "FROM friendships f INNER JOIN users u ON u.user_id = f.friend_id "
+        "WHERE f.user_id = ? AND f.friend_id > ? "
+        "AND (f.update_time > FROM_UNIXTIME(? / 1000) OR u.update_time > FROM_UNIXTIME(? / 1000)) "
+        "ORDER BY f.friend_id LIMIT ?";
+}
+
+const char* userStatusName(UserStatus status) {
+    switch (status) {
+    case UserStatus::ONLINE:
+        return "online";
+    case UserStatus::AWAY:
+        return "away";
+    default:
+        return "offline";
+    }
+}
+
+bool parseUserStatus(std::string_view name, UserStatus& status) {
+    if (name == "online") {
+        status = UserStatus::ONLINE;
+    } else if (name == "offline") {
+        status = UserStatus::OFFLINE;
+    } else if (name == "away") {
+        status = UserStatus::AWAY;
+    } else {
+        return false;
+    }
+    return true;
+}
 
 DAOResult<void> UserDAO::addUser(const UserEntity& user) {
     DAO_TRY
-        auto connWrapper = getConnection();
-        auto conn = connWrapper->getConnection();
-        
-        // Call add user procedure
-        auto stmt = prepareProcedureCall("proc_add_user", 6, conn);
-        stmt->setString(1, user.username);
-        stmt->setString(2, user.password);
-        stmt->setString(3, user.nickname);
-        stmt->setString(4, user.avatar);
-        stmt->setString(5, user.email);
-        stmt->setString(6, user.status);
-        
-        stmt->execute();
-        
-        return DAOResult<void>(true, "User added successfully");
+        return executeWrite([&](ConnectionWrapper* connWrapper) -> DAOResult<void> {
+            // Call add user procedure
+            auto stmt = prepareProcedureCall("proc_add_user", 6, connWrapper);
+            stmt->setString(1, user.username);
+            stmt->setString(2, user.password);
+            stmt->setString(3, user.nickname);
+            stmt->setString(4, user.avatar.str());
+            stmt->setString(5, user.email);
+            stmt->setString(6, userStatusName(user.status));
+            
+            stmt->execute();
+            
+            return DAOResult<void>(true, "User added successfully");
+        });
     DAO_CATCH(void)
 }
 
 DAOResult<UserEntity> UserDAO::findByUsername(const std::string& username) {
     DAO_TRY
-        auto connWrapper = getConnection();
-        auto conn = connWrapper->getConnection();
-        
-        // Call find user by username procedure
-        auto stmt = prepareProcedureCall("proc_find_user_by_username", 1, conn);
-        stmt->setString(1, username);
-        
-        auto rs = std::shared_ptr<sql::ResultSet>(stmt->executeQuery());
-        if (rs->next()) {
-            auto user = std::make_shared<UserEntity>(buildUserFromResultSet(rs.get()));
-            return DAOResult<UserEntity>(true, "User found", user);
-        }
-        return DAOResult<UserEntity>(false, "User not found");
+        return executeRead([&](ConnectionWrapper* connWrapper) -> DAOResult<UserEntity> {
+            // Call find user by username procedure
+            auto stmt = prepareProcedureCall("proc_find_user_by_username", 1, connWrapper);
+            stmt->setString(1, username);
+            
+            auto rs = std::shared_ptr<sql::ResultSet>(stmt->executeQuery());
+            if (rs->next()) {
+                auto user = std::make_shared<UserEntity>(buildUserFromResultSet(rs.get()));
+                return DAOResult<UserEntity>(true, "User found", user);
+            }
+            return DAOResult<UserEntity>(false, "User not found");
+        });
     DAO_CATCH(UserEntity)
 }
 
-DAOResult<UserEntity> UserDAO::findById(int64_t userId) {
+DAOResult<UserEntity> UserDAO::findById(int64_t userId, ReadRoute route) {
     DAO_TRY
-        auto connWrapper = getConnection();
-        auto conn = connWrapper->getConnection();
-        
-        // Call find user by ID procedure
-        auto stmt = prepareProcedureCall("proc_find_user_by_id", 1, conn);
-        stmt->setInt64(1, userId);
-        
-        auto rs = std::shared_ptr<sql::ResultSet>(stmt->executeQuery());
-        if (rs->next()) {
-            auto user = std::make_shared<UserEntity>(buildUserFromResultSet(rs.get()));
-            return DAOResult<UserEntity>(true, "User found", user);
-        }
-        return DAOResult<UserEntity>(false, "User not found");
+        return executeRead(route, [&](ConnectionWrapper* connWrapper) -> DAOResult<UserEntity> {
+            // Call find user by ID procedure
+            auto stmt = prepareProcedureCall("proc_find_user_by_id", 1, connWrapper);
+            stmt->setInt64(1, userId);
+            
+            auto rs = std::shared_ptr<sql::ResultSet>(stmt->executeQuery());
+            if (rs->next()) {
+                auto user = std::make_shared<UserEntity>(buildUserFromResultSet(rs.get()));
+                return DAOResult<UserEntity>(true, "User found", user);
+            }
+            return DAOResult<UserEntity>(false, "User not found");
+        });
     DAO_CATCH(UserEntity)
 }
 
-DAOResult<void> UserDAO::updateUserStatus(int64_t userId, const std::string& status) {
+DAOResult<void> UserDAO::updateUserStatus(int64_t userId, UserStatus status) {
     DAO_TRY
-        auto connWrapper = getConnection();
-        auto conn = connWrapper->getConnection();
-        
-        // Call update user status procedure
-        auto stmt = prepareProcedureCall("proc_update_user_status", 2, conn);
-        stmt->setInt64(1, userId);
-        stmt->setString(2, status);
-        
-        stmt->execute();
-        
-        return DAOResult<void>(true, "Status updated");
+        return executeWrite([&](ConnectionWrapper* connWrapper) -> DAOResult<void> {
+            // Call update user status procedure
+            auto stmt = prepareProcedureCall("proc_update_user_status", 2, connWrapper);
+            stmt->setInt64(1, userId);
+            stmt->setString(2, userStatusName(status));
+            
+            stmt->execute();
+            
+            return DAOResult<void>(true, "Status updated");
+        });
     DAO_CATCH(void)
 }
 
 DAOResult<void> UserDAO::updateLastLoginTime(int64_t userId) {
     DAO_TRY
-        auto connWrapper = getConnection();
-        auto conn = connWrapper->getConnection();
-        
-        // Call update login time procedure
-        auto stmt = prepareProcedureCall("proc_update_last_login_time", 1, conn);
-        stmt->setInt64(1, userId);
-        
-        stmt->execute();
-        
-        return DAOResult<void>(true, "Login time updated");
+        return executeWrite([&](ConnectionWrapper* connWrapper) -> DAOResult<void> {
+            // Call update login time procedure
+            auto stmt = prepareProcedureCall("proc_update_last_login_time", 1, connWrapper);
+            stmt->setInt64(1, userId);
+            
+            stmt->execute();
+            
+            return DAOResult<void>(true, "Login time updated");
+        });
     DAO_CATCH(void)
 }
 
-DAOResult<std::vector<UserEntity>> UserDAO::getFriendList(int64_t userId) {
+DAOResult<std::vector<UserEntity>> UserDAO::getFriendList(int64_t userId, ReadRoute route) {
     DAO_TRY
-        auto connWrapper = getConnection();
-        auto conn = connWrapper->getConnection();
-        
-        // Call get friend list procedure
-        auto stmt = prepareProcedureCall("proc_get_friend_list", 1, conn);
-        stmt->setInt64(1, userId);
-        
-        auto rs = std::shared_ptr<sql::ResultSet>(stmt->executeQuery());
-        std::vector<UserEntity> friends;
-        
-        while (rs->next()) {
-            friends.push_back(buildUserFromResultSet(rs.get()));
-        }
-        
-        auto result = std::make_shared<std::vector<UserEntity>>(std::move(friends));
-        return DAOResult<std::vector<UserEntity>>(true, "Friend list retrieved", result);
+        return executeRead(route, [&](ConnectionWrapper* connWrapper) -> DAOResult<std::vector<UserEntity>> {
+            // Call get friend list procedure
+            auto stmt = prepareProcedureCall("proc_get_friend_list", 1, connWrapper);
+            stmt->setInt64(1, userId);
+            
+            auto rs = std::shared_ptr<sql::ResultSet>(stmt->executeQuery());
+            std::vector<UserEntity> friends;
+            
+            while (rs->next()) {
+                friends.push_back(buildUserFromResultSet(rs.get()));
+            }
+            
+            auto result = std::make_shared<std::vector<UserEntity>>(std::move(friends));
+            return DAOResult<std::vector<UserEntity>>(true, "Friend list retrieved", result);
+        });
     DAO_CATCH(std::vector<UserEntity>)
 }
 
-DAOResult<bool> UserDAO::verifyPassword(const std::string& username, const std::string& password) {
+DAOResult<FriendPage> UserDAO::getFriendPage(int64_t userId, int64_t afterId, int limit, int64_t sinceVersion,
+                                             int64_t syncVersion, const std::function<void(const FriendRow&)>& onRow) {
+    limit = std::clamp(limit, 1, FRIEND_PAGE_MAX_LIMIT);
+    bool delta = sinceVersion > 0;
+    
     DAO_TRY
-        auto connWrapper = getConnection();
-        auto conn = connWrapper->getConnection();
-        
-        // Call verify password procedure
-        auto stmt = prepareProcedureCall("proc_verify_password", 2, conn);
-        stmt->setString(1, username);
-        stmt->setString(2, password);
-        
-        auto rs = std::shared_ptr<sql::ResultSet>(stmt->executeQuery());
-        bool verified = false;
-        
-        if (rs->next()) {
-            verified = rs->getInt("result") > 0;
+        // One stamp per sync: later pages carry the first page's version back, so
+        // a change that lands between pages is picked up by the next delta.
+        // Taken on the primary clock before the first page is read, minus the
+        // replica lag bound, so nothing the replica has not applied yet is skipped.
+        int64_t version = syncVersion;
+        if (version <= 0) {
+            version = executeRead([](ConnectionWrapper* connWrapper) -> int64_t {
+                auto clock = connWrapper->prepareCached("SELECT CAST(UNIX_TIMESTAMP(NOW(3)) * 1000 AS SIGNED)");
+                std::unique_ptr<sql::ResultSet> now(clock->executeQuery());
+                return now->next() ? now->getInt64(1) : 0;
+            });
+            int64_t overlap = FRIEND_SYNC_OVERLAP_MS + gDBManager.getReplicaLagBound() * int64_t(1000);
+            version = std::max<int64_t>(version - overlap, 1);
         }
         
-        auto result = std::make_shared<bool>(verified);
-        return DAOResult<bool>(true, verified ? "Password verified" : "Password incorrect", result);
+        // Rows already handed to onRow cannot be taken back, so a failed page
+        // is not retried on another connection
+        return executeStreamingRead(ReadRoute::REPLICA, [&](ConnectionWrapper* connWrapper) -> DAOResult<FriendPage> {
+            auto page = std::make_shared<FriendPage>();
+            page->version = version;
+            
+            auto stmt = connWrapper->prepareCached(delta ? FRIEND_DELTA_SQL : FRIEND_PAGE_SQL);
+            int index = 1;
+            stmt->setInt64(index++, userId);
+            stmt->setInt64(index++, afterId);
+            if (delta) {
+                stmt->setInt64(index++, sinceVersion);
+                stmt->setInt64(index++, sinceVersion);
+            }
+            stmt->setInt(index++, limit + 1);
+            
+            // Rows go straight to the caller; one FriendRow is reused for the whole page
+            std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery());
+            FriendRow row;
+            while (rs->next()) {
+                if (page->count == limit) {
+                    page->hasMore = true;
+                    break;
+                }
+                row.userId = rs->getInt64(1);
+                row.username = rs->getString(2);
+                row.nickname = rs->getString(3);
+                row.avatar = rs->getString(4);
+                row.status = UserStatus::OFFLINE;
+                parseUserStatus(std::string(rs->getString(5)), row.status);
+                row.removed = rs->getBoolean(6);
+                onRow(row);
+                page->lastId = row.userId;
+                page->count++;
+            }
+            
+            return DAOResult<FriendPage>(true, "Friend page retrieved", page);
+        });
+    DAO_CATCH(FriendPage)
+}
+
+DAOResult<bool> UserDAO::verifyPassword(const std::string& username, const std::string& password) {
+    DAO_TRY
+        return executeRead([&](ConnectionWrapper* connWrapper) -> DAOResult<bool> {
+            // Call verify password procedure
+            auto stmt = prepareProcedureCall("proc_verify_password", 2, connWrapper);
+            stmt->setString(1, username);
+            stmt->setString(2, password);
+            
+            auto rs = std::shared_ptr<sql::ResultSet>(stmt->executeQuery());
+            bool verified = false;
+            
+            if (rs->next()) {
+                verified = rs->getInt("result") > 0;
+            }
+            
+            auto result = std::make_shared<bool>(verified);
+            return DAOResult<bool>(true, verified ? "Password verified" : "Password incorrect", result);
+        });
     DAO_CATCH(bool)
 }
 
+DAOResult<UserEntity> UserDAO::login(const std::string& username, const std::string& password) {
+    DAO_TRY
+        return executeRead([&](ConnectionWrapper* connWrapper) -> DAOResult<UserEntity> {
+            // Verify password and fetch the user in one call
+            auto stmt = prepareProcedureCall("proc_login_user", 2, connWrapper);
+            stmt->setString(1, username);
+            stmt->setString(2, password);
+            
+            auto rs = std::shared_ptr<sql::ResultSet>(stmt->executeQuery());
+            if (rs->next()) {
+                auto user = std::make_shared<UserEntity>(buildUserFromResultSet(rs.get()));
+                return DAOResult<UserEntity>(true, "Password verified", user);
+            }
+            return DAOResult<UserEntity>(true, "Invalid username or password");
+        });
+    DAO_CATCH(UserEntity)
+}
+
 DAOResult<void> UserDAO::addFriend(int64_t userId, int64_t friendId) {
     DAO_TRY
-        auto connWrapper = getConnection();
-        auto conn = connWrapper->getConnection();
-        
         // Execute transaction to ensure atomicity
         return executeTransaction([this, userId, friendId](sql::Connection* conn) -> DAOResult<void> {
             // Call add friend procedure
@@ -152,70 +285,146 @@ DAOResult<void> UserDAO::addFriend(int64_t userId, int64_t friendId) {
 
 DAOResult<void> UserDAO::removeFriend(int64_t userId, int64_t friendId) {
     DAO_TRY
-        auto connWrapper = getConnection();
-        auto conn = connWrapper->getConnection();
-        
-        // Call remove friend procedure
-        auto stmt = prepareProcedureCall("proc_remove_friend", 2, conn);
-        stmt->setInt64(1, userId);
-        stmt->setInt64(2, friendId);
-        
-        stmt->execute();
-        
-        return DAOResult<void>(true, "Friend removed");
+        return executeWrite([&](ConnectionWrapper* connWrapper) -> DAOResult<void> {
+            // Call remove friend procedure
+            auto stmt = prepareProcedureCall("proc_remove_friend", 2, connWrapper);
+            stmt->setInt64(1, userId);
+            stmt->setInt64(2, friendId);
+            
+            stmt->execute();
+            
+            return DAOResult<void>(true, "Friend removed");
+        });
     DAO_CATCH(void)
 }
 
-DAOResult<std::vector<UserEntity>> UserDAO::batchGetUserInfo(const std::vector<int64_t>& userIds) {
+DAOResult<std::vector<UserEntity>> UserDAO::batchGetUserInfo(std::span<const int64_t> userIds, ReadRoute route) {
     if (userIds.empty()) {
         return DAOResult<std::vector<UserEntity>>(true, "User ID list is empty", 
                                                std::make_shared<std::vector<UserEntity>>());
     }
     
+    // Each id is fetched once, however often it was requested; the id list
+    // lives in a stack arena for the duration of the call
+    std::byte arenaBuffer[DB_BATCH_ARENA_BYTES];
+    std::pmr::monotonic_buffer_resource arena(arenaBuffer, sizeof(arenaBuffer));
+    std::pmr::vector<int64_t> ids(userIds.begin(), userIds.end(), &arena);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    
     DAO_TRY
-        auto connWrapper = getConnection();
-        auto conn = connWrapper->getConnection();
-        
-        // Build user ID list string
-        std::string idListStr = buildUserIdList(userIds);
-        
-        // Call batch get user info procedure
-        auto stmt = prepareProcedureCall("proc_batch_get_user_info", 1, conn);
-        stmt->setString(1, idListStr);
-        
-        auto rs = std::shared_ptr<sql::ResultSet>(stmt->executeQuery());
-        std::vector<UserEntity> users;
-        
-        while (rs->next()) {
-            users.push_back(buildUserFromResultSet(rs.get()));
-        }
-        
-        auto result = std::make_shared<std::vector<UserEntity>>(std::move(users));
-        return DAOResult<std::vector<UserEntity>>(true, "Users retrieved", result);
+        return executeRead(route, [&](ConnectionWrapper* connWrapper) -> DAOResult<std::vector<UserEntity>> {
+            std::vector<UserEntity> users;
+            users.reserve(ids.size());
+            
+            for (size_t offset = 0; offset < ids.size(); offset += DB_BULK_LOOKUP_CHUNK_SIZE) {
+                size_t count = std::min(ids.size() - offset, static_cast<size_t>(DB_BULK_LOOKUP_CHUNK_SIZE));
+                
+                // Round the placeholder count up to a power of two so only a few
+                // statement shapes exist and all of them stay in the statement cache;
+                // the padding repeats the last id, which IN ignores
+                size_t slots = 1;
+                while (slots < count) {
+                    slots <<= 1;
+                }
+                auto stmt = connWrapper->prepareCached(buildBulkSelect(slots));
+                for (size_t i = 0; i < slots; i++) {
+                    stmt->setInt64(static_cast<int>(i + 1), ids[offset + std::min(i, count - 1)]);
+                }
+                
+                std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery());
+                while (rs->next()) {
+                    users.push_back(buildUserFromResultSet(rs.get()));
+                }
+            }
+            
+            auto result = std::make_shared<std::vector<UserEntity>>(std::move(users));
+            return DAOResult<std::vector<UserEntity>>(true, "Users retrieved", result);
+        });
     DAO_CATCH(std::vector<UserEntity>)
 }
 
-std::string UserDAO::buildUserIdList(const std::vector<int64_t>& userIds) {
-    std::stringstream ss;
-    for (size_t i = 0; i < userIds.size(); i++) {
+DAOResult<void> UserDAO::batchUpdateUsers(const std::vector<std::pair<int64_t, UserStatus>>& statusUpdates,
+                                           const std::vector<std::pair<int64_t, int64_t>>& loginUpdates) {
+    if (statusUpdates.empty() && loginUpdates.empty()) {
+        return DAOResult<void>(true, "Nothing to update");
+    }
+    
+    DAO_TRY
+        return executeTransaction([&](sql::Connection* conn) -> DAOResult<void> {
+            // UPDATE users SET status = CASE user_id WHEN ? THEN ? ... END WHERE user_id IN (?, ...)
+            if (!statusUpdates.empty()) {
+                auto stmt = std::shared_ptr<sql::PreparedStatement>(conn->prepareStatement(
+                    buildCaseUpdate("status", "?", statusUpdates.size())));
+                int index = 1;
+                for (auto& update : statusUpdates) {
+                    stmt->setInt64(index++, update.first);
+                    stmt->setString(index++, userStatusName(update.second));
+                }
+                for (auto& update : statusUpdates) {
+                    stmt->setInt64(index++, update.first);
+                }
+                stmt->executeUpdate();
+            }
+            
+            if (!loginUpdates.empty()) {
+                auto stmt = std::shared_ptr<sql::PreparedStatement>(conn->prepareStatement(
+                    buildCaseUpdate("last_login_time", "FROM_UNIXTIME(?)", loginUpdates.size())));
+                int index = 1;
+                for (auto& update : loginUpdates) {
+                    stmt->setInt64(index++, update.first);
+                    stmt->setInt64(index++, update.second);
+                }
+                for (auto& update : loginUpdates) {
+                    stmt->setInt64(index++, update.first);
+                }
+                stmt->executeUpdate();
+            }
+            
+            return DAOResult<void>(true, "Users updated");
+        });
+    DAO_CATCH(void)
+}
+
+std::string UserDAO::buildCaseUpdate(const std::string& column, const std::string& valueExpr, size_t rows) {
+    std::string sql = "UPDATE users SET " + column + " = CASE user_id";
+    for (size_t i = 0; i < rows; i++) {
+        sql += " WHEN ? THEN " + valueExpr;
+    }
+    sql += " END WHERE user_id IN (";
+    for (size_t i = 0; i < rows; i++) {
         if (i > 0) {
-            ss << ",";
+            sql += ",";
         }
-        ss << userIds[i];
+        sql += "?";
     }
-    return ss.str();
+    sql += ")";
+    return sql;
+}
+
+std::string UserDAO::buildBulkSelect(size_t slots) {
+    std::string sql = std::string("SELECT ") + BULK_USER_COLUMNS + " FROM users WHERE user_id IN (";
+    for (size_t i = 0; i < slots; i++) {
+        if (i > 0) {
+            sql += ",";
+        }
+        sql += "?";
+    }
+    sql += ")";
+    return sql;
 }
 
 UserEntity UserDAO::buildUserFromResultSet(sql::ResultSet* rs) {
     UserEntity user;
-    user.userId = rs->getInt64("user_id");
-    user.username = rs->getString("username");
-    user.password = rs->getString("password");
-    user.nickname = rs->getString("nickname");
-    user.avatar = rs->getString("avatar");
-    user.email = rs->getString("email");
-    user.status = rs->getString("status");
-    user.createTime = rs->getString("create_time");
-    user.lastLoginTime = rs->getString("last_login_time");
+    user.userId = rs->getInt64(COL_USER_ID);
+    user.username = rs->getString(COL_USERNAME);
+    user.password = rs->getString(COL_PASSWORD);
+    user.nickname = rs->getString(COL_NICKNAME);
+    user.avatar = InternedString(std::string(rs->getString(COL_AVATAR)));
+    user.email = rs->getString(COL_EMAIL);
+    parseUserStatus(std::string(rs->getString(COL_STATUS)), user.status);
+    // NULL reads as 0
+    user.createTime = rs->getInt64(COL_CREATE_TIME);
+    user.lastLoginTime = rs->getInt64(COL_LAST_LOGIN_TIME);
     return user;
-} 
\ No newline at end of file
+}
@@ -2,18 +2,54 @@
 #include "BaseDAO.h"
 #include <vector>
 #include <optional>
+#include <functional>
+#include <span>
+#include "../StringInterner.h"
+
+// 用户状态，与users.status的ENUM取值一一对应
+enum class UserStatus : uint8_t {
+    OFFLINE,
+    ONLINE,
+    AWAY
+};
+
+// 数据库和JSON中使用的状态字符串
+const char* userStatusName(UserStatus status);
+
+// 解析状态字符串，不认识的值返回false
+bool parseUserStatus(std::string_view name, UserStatus& status);
 
 // 用户实体类
+// 缓存里常驻大量用户，字段尽量紧凑：状态是一个字节，时间是Unix时间戳(秒)，
+// 头像多数用户相同，驻留后共享一份；昵称通常很短，落在std::string的短字符串优化里不分配内存
 struct UserEntity {
-    int64_t userId;
+    int64_t userId = 0;
+    int64_t createTime = 0;
+    int64_t lastLoginTime = 0;
     std::string username;
     std::string password;
     std::string nickname;
-    std::string avatar;
     std::string email;
-    std::string status;
-    std::string createTime;
-    std::string lastLoginTime;
+    InternedString avatar;
+    UserStatus status = UserStatus::OFFLINE;
+};
+
+// 分页读取好友时的一行，只含好友列表需要的字段；同一个对象在各行之间复用
+struct FriendRow {
+    int64_t userId = 0;
+    std::string username;
+    std::string nickname;
+    std::string avatar;
+    UserStatus status = UserStatus::OFFLINE;
+    bool removed = false;   // 增量模式下表示已不是好友，此时只有userId有意义
+};
+
+// 一页好友的分页信息
+struct FriendPage {
+    int count = 0;          // 本页行数
+    int64_t lastId = 0;     // 本页最后一个好友的userId，作为下一页的afterId
+    bool hasMore = false;   // 后面是否还有数据
+    int64_t version = 0;    // 同步完所有页后，下次增量同步使用的sinceVersion(毫秒)，一次同步的各页相同
 };
 
 class UserDAO : public BaseDAO {
@@ -26,26 +62,39 @@ public:
     // 参数: username
     DAOResult<UserEntity> findByUsername(const std::string& username);
     
-    // 通过用户ID查找用户 (proc_find_user_by_id)
+    // 通过用户ID查找用户 (proc_find_user_by_id)，默认读只读副本；结果要回填缓存时传PRIMARY
     // 参数: user_id
-    DAOResult<UserEntity> findById(int64_t userId);
+    DAOResult<UserEntity> findById(int64_t userId, ReadRoute route = ReadRoute::REPLICA);
     
     // 更新用户状态 (proc_update_user_status)
     // 参数: user_id, status
-    DAOResult<void> updateUserStatus(int64_t userId, const std::string& status);
+    DAOResult<void> updateUserStatus(int64_t userId, UserStatus status);
     
     // 更新最后登录时间 (proc_update_last_login_time)
     // 参数: user_id
     DAOResult<void> updateLastLoginTime(int64_t userId);
     
-    // 获取用户好友列表 (proc_get_friend_list)
+    // 获取用户好友列表 (proc_get_friend_list)，默认读只读副本；结果要回填缓存时传PRIMARY
     // 参数: user_id
-    DAOResult<std::vector<UserEntity>> getFriendList(int64_t userId);
+    DAOResult<std::vector<UserEntity>> getFriendList(int64_t userId, ReadRoute route = ReadRoute::REPLICA);
+    
+    // 按好友userId做keyset分页读取好友列表，读只读副本
+    // 参数: user_id, afterId(上一页的lastId，第一页为0), limit(每页条数，最大FRIEND_PAGE_MAX_LIMIT),
+    //       sinceVersion(0表示全量，否则只返回该版本之后资料有变化、新加或删除的好友),
+    //       syncVersion(本次同步第一页返回的version，第一页为0，此时按主库时钟生成新的version)
+    // 每一行直接交给onRow，不在内存中保存整个列表；查询中途出错时不重试，调用方应丢弃已收到的行
+    DAOResult<FriendPage> getFriendPage(int64_t userId, int64_t afterId, int limit, int64_t sinceVersion,
+                                        int64_t syncVersion, const std::function<void(const FriendRow&)>& onRow);
     
     // 验证用户密码 (proc_verify_password)
     // 参数: username, password
     DAOResult<bool> verifyPassword(const std::string& username, const std::string& password);
     
+    // 登录：校验密码并返回用户信息，一次往返 (proc_login_user)
+    // 参数: username, password
+    // 用户名或密码错误时isSuccess()为true，getData()为空
+    DAOResult<UserEntity> login(const std::string& username, const std::string& password);
+    
     // 添加好友关系 (proc_add_friend)
     // 参数: user_id, friend_id
     DAOResult<void> addFriend(int64_t userId, int64_t friendId);
@@ -54,14 +103,24 @@ public:
     // 参数: user_id, friend_id
     DAOResult<void> removeFriend(int64_t userId, int64_t friendId);
     
-    // 批量获取用户信息 (proc_batch_get_user_info)
-    // 参数: user_ids (逗号分隔的ID列表)
-    DAOResult<std::vector<UserEntity>> batchGetUserInfo(const std::vector<int64_t>& userIds);
+    // 批量写入用户状态和最后登录时间，每类更新合并成一条多行UPDATE，在同一事务中执行
+    // 参数: statusUpdates (user_id, status), loginUpdates (user_id, 登录时间的Unix时间戳)
+    DAOResult<void> batchUpdateUsers(const std::vector<std::pair<int64_t, UserStatus>>& statusUpdates,
+                                     const std::vector<std::pair<int64_t, int64_t>>& loginUpdates);
+    
+    // 批量获取用户信息，默认读只读副本；结果要回填缓存时传PRIMARY
+    // 参数: user_ids，重复的id只查一次，按DB_BULK_LOOKUP_CHUNK_SIZE分批用IN (?, ...)查询
+    // 返回的用户不含密码，顺序不保证与参数一致，不存在的id没有对应结果
+    DAOResult<std::vector<UserEntity>> batchGetUserInfo(std::span<const int64_t> userIds,
+                                                        ReadRoute route = ReadRoute::REPLICA);
     
 private:
-    // 从结果集构造用户实体
+    // 从结果集构造用户实体，按列序号读取，结果集的列顺序必须与UserColumn一致
     UserEntity buildUserFromResultSet(sql::ResultSet* rs);
     
-    // 构建用户ID列表字符串
-    std::string buildUserIdList(const std::vector<int64_t>& userIds);
+    // 构建按user_id批量查询的SELECT语句，列顺序与UserColumn一致但密码列为空串，slots为占位符个数
+    std::string buildBulkSelect(size_t slots);
+    
+    // 构建按user_id分别赋值的多行UPDATE语句
+    std::string buildCaseUpdate(const std::string& column, const std::string& valueExpr, size_t rows);
 }; 
\ No newline at end of file
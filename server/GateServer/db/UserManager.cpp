@@ -1,6 +1,11 @@
 #include "UserManager.h"
 #include "DBConnectionPool.h"
+#include "UserCache.h"
+#include "UserWriteBehind.h"
 #include <iostream>
+#include <memory_resource>
+#include <unordered_map>
+#include <unordered_set>
 
 bool UserManager::init() {
     // Initialize any necessary components
@@ -23,7 +28,7 @@ ManagerResult<UserEntity> UserManager::registerUser(const std::string& username,
     user.password = password;  // Note: In a real application, password should be encrypted
     user.nickname = nickname.empty() ? username : nickname;
     user.avatar = avatar.empty() ? "default.png" : avatar;
-    user.status = "offline";  // Initial status is offline
+    user.status = UserStatus::OFFLINE;  // Initial status is offline
     
     // Add user
     auto result = m_userDao.addUser(user);
@@ -42,45 +47,45 @@ ManagerResult<UserEntity> UserManager::registerUser(const std::string& username,
 
 ManagerResult<UserEntity> UserManager::login(const std::string& username, 
                                           const std::string& password) {
-    // Verify password
-    auto verifyResult = m_userDao.verifyPassword(username, password);
-    if (!verifyResult.isSuccess()) {
-        return ManagerResult<UserEntity>(ResultCode::DATABASE_ERROR, verifyResult.getMessage());
+    // Credentials are always checked by the database, never against a cached
+    // copy, so a changed password takes effect at once; one round trip
+    auto loginResult = m_userDao.login(username, password);
+    if (!loginResult.isSuccess()) {
+        return ManagerResult<UserEntity>(ResultCode::DATABASE_ERROR, loginResult.getMessage());
     }
     
-    if (!(*verifyResult.getData())) {
+    if (!loginResult.getData()) {
         return ManagerResult<UserEntity>(ResultCode::INVALID_PASSWORD, "Invalid username or password");
     }
+    auto user = loginResult.getData();
     
-    // Get user information
-    auto userResult = m_userDao.findByUsername(username);
-    if (!userResult.isSuccess() || !userResult.getData()) {
-        return ManagerResult<UserEntity>(ResultCode::USER_NOT_FOUND, "User not found");
-    }
-    
-    auto user = userResult.getData();
-    
-    // Update user status and login time
-    m_userDao.updateUserStatus(user->userId, "online");  // 使用"online"表示在线状态
-    m_userDao.updateLastLoginTime(user->userId);
+    // Status and login time are written behind, off the login path
+    UserWriteBehind::GetInstance()->recordLogin(user->userId);
     
-    // Update user status in memory
-    user->status = "online";
+    // Update user status in memory and write it through to the cache
+    user->status = UserStatus::ONLINE;
+    UserCache::GetInstance()->put(*user);
     
     return ManagerResult<UserEntity>(ResultCode::SUCCESS, "Login successful", user);
 }
 
 ManagerResult<void> UserManager::logout(int64_t userId) {
-    auto result = m_userDao.updateUserStatus(userId, "offline");  // 0 means offline
-    if (!result.isSuccess()) {
-        return ManagerResult<void>(ResultCode::FAILED, result.getMessage());
-    }
+    // Status flips are coalesced and written behind
+    UserWriteBehind::GetInstance()->updateStatus(userId, UserStatus::OFFLINE);
+    UserCache::GetInstance()->updateStatus(userId, UserStatus::OFFLINE);
     
     return ManagerResult<void>(ResultCode::SUCCESS, "Logout successful");
 }
 
 ManagerResult<UserEntity> UserManager::getUserInfo(int64_t userId) {
-    auto result = m_userDao.findById(userId);
+    auto cached = UserCache::GetInstance()->getById(userId);
+    if (cached) {
+        return ManagerResult<UserEntity>(ResultCode::SUCCESS, "User information retrieved successfully", cached);
+    }
+    
+    // Cache fills read the primary: a lagging replica would put back data an
+    // invalidation just removed, and it would stay until the entry expires
+    auto result = m_userDao.findById(userId, ReadRoute::PRIMARY);
     if (!result.isSuccess()) {
         return ManagerResult<UserEntity>(ResultCode::DATABASE_ERROR, result.getMessage());
     }
@@ -89,10 +94,16 @@ ManagerResult<UserEntity> UserManager::getUserInfo(int64_t userId) {
         return ManagerResult<UserEntity>(ResultCode::USER_NOT_FOUND, "User not found");
     }
     
+    UserCache::GetInstance()->put(*result.getData());
     return ManagerResult<UserEntity>(ResultCode::SUCCESS, "User information retrieved successfully", result.getData());
 }
 
 ManagerResult<UserEntity> UserManager::getUserInfoByUsername(const std::string& username) {
+    auto cached = UserCache::GetInstance()->getByUsername(username);
+    if (cached) {
+        return ManagerResult<UserEntity>(ResultCode::SUCCESS, "User information retrieved successfully", cached);
+    }
+    
     auto result = m_userDao.findByUsername(username);
     if (!result.isSuccess()) {
         return ManagerResult<UserEntity>(ResultCode::DATABASE_ERROR, result.getMessage());
@@ -102,36 +113,56 @@ ManagerResult<UserEntity> UserManager::getUserInfoByUsername(const std::string&
         return ManagerResult<UserEntity>(ResultCode::USER_NOT_FOUND, "User not found");
     }
     
+    UserCache::GetInstance()->put(*result.getData());
     return ManagerResult<UserEntity>(ResultCode::SUCCESS, "User information retrieved successfully", result.getData());
 }
 
 ManagerResult<std::vector<UserEntity>> UserManager::getFriendList(int64_t userId) {
-    auto result = m_userDao.getFriendList(userId);
+    auto cache = UserCache::GetInstance();
+    
+    // Cached friend ids: resolve profiles cache-first, load only the misses in bulk
+    auto friendIds = cache->getFriendIds(userId);
+    if (friendIds) {
+        return batchGetUserInfo(*friendIds);
+    }
+    
+    // Read from the primary, the ids are cached (see getUserInfo)
+    auto result = m_userDao.getFriendList(userId, ReadRoute::PRIMARY);
     if (!result.isSuccess()) {
         return ManagerResult<std::vector<UserEntity>>(ResultCode::DATABASE_ERROR, result.getMessage());
     }
     
+    std::vector<int64_t> ids;
+    ids.reserve(result.getData()->size());
+    for (auto& user : *result.getData()) {
+        ids.push_back(user.userId);
+    }
+    cache->putMany(*result.getData());
+    cache->putFriendIds(userId, std::move(ids));
+    
+    // Friends never see each other's password hash
+    for (auto& user : *result.getData()) {
+        user.password.clear();
+    }
     return ManagerResult<std::vector<UserEntity>>(ResultCode::SUCCESS, "Friend list retrieved successfully", result.getData());
 }
 
-ManagerResult<void> UserManager::updateUserStatus(int64_t userId, const std::string& status) {
-    auto result = m_userDao.updateUserStatus(userId, status);
-    if (!result.isSuccess()) {
-        return ManagerResult<void>(ResultCode::FAILED, result.getMessage());
-    }
+ManagerResult<void> UserManager::updateUserStatus(int64_t userId, UserStatus status) {
+    UserWriteBehind::GetInstance()->updateStatus(userId, status);
+    UserCache::GetInstance()->updateStatus(userId, status);
     
     return ManagerResult<void>(ResultCode::SUCCESS, "User status updated successfully");
 }
 
 ManagerResult<void> UserManager::addFriend(int64_t userId, int64_t friendId) {
     // Check if user exists
-    auto userResult = m_userDao.findById(userId);
+    auto userResult = getUserInfo(userId);
     if (!userResult.isSuccess() || !userResult.getData()) {
         return ManagerResult<void>(ResultCode::USER_NOT_FOUND, "User not found");
     }
     
     // Check if friend exists
-    auto friendResult = m_userDao.findById(friendId);
+    auto friendResult = getUserInfo(friendId);
     if (!friendResult.isSuccess() || !friendResult.getData()) {
         return ManagerResult<void>(ResultCode::USER_NOT_FOUND, "Friend not found");
     }
@@ -145,6 +176,10 @@ ManagerResult<void> UserManager::addFriend(int64_t userId, int64_t friendId) {
         return ManagerResult<void>(ResultCode::FAILED, result.getMessage());
     }
     
+    // Friendship is stored in both directions
+    UserCache::GetInstance()->invalidateFriendIds(userId);
+    UserCache::GetInstance()->invalidateFriendIds(friendId);
+    
     return ManagerResult<void>(ResultCode::SUCCESS, "Friend added successfully");
 }
 
@@ -155,14 +190,69 @@ ManagerResult<void> UserManager::removeFriend(int64_t userId, int64_t friendId)
         return ManagerResult<void>(ResultCode::FAILED, result.getMessage());
     }
     
+    UserCache::GetInstance()->invalidateFriendIds(userId);
+    UserCache::GetInstance()->invalidateFriendIds(friendId);
+    
     return ManagerResult<void>(ResultCode::SUCCESS, "Friend removed successfully");
 }
 
 ManagerResult<std::vector<UserEntity>> UserManager::batchGetUserInfo(const std::vector<int64_t>& userIds) {
-    auto result = m_userDao.batchGetUserInfo(userIds);
-    if (!result.isSuccess()) {
-        return ManagerResult<std::vector<UserEntity>>(ResultCode::DATABASE_ERROR, result.getMessage());
+    auto cache = UserCache::GetInstance();
+    
+    // Id bookkeeping lives in a per-request arena: one stack buffer, freed at once on return
+    std::byte arenaBuffer[DB_BATCH_ARENA_BYTES];
+    std::pmr::monotonic_buffer_resource arena(arenaBuffer, sizeof(arenaBuffer));
+    
+    // Dedup while keeping the caller's order
+    std::pmr::vector<int64_t> ids(&arena);
+    ids.reserve(userIds.size());
+    std::pmr::unordered_set<int64_t> seen(&arena);
+    seen.reserve(userIds.size());
+    for (auto id : userIds) {
+        if (seen.insert(id).second) {
+            ids.push_back(id);
+        }
+    }
+    
+    // Cache first: in-process LRU, then one pipelined MGET for the rest
+    std::vector<std::shared_ptr<UserEntity>> slots;
+    cache->getMany(ids, slots);
+    std::pmr::vector<int64_t> missing(&arena);
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (!slots[i]) {
+            missing.push_back(ids[i]);
+        }
+    }
+    
+    // Only the misses go to the database, in chunked IN queries, on the
+    // primary since the results are cached (see getUserInfo)
+    std::pmr::unordered_map<int64_t, UserEntity*> loaded(&arena);
+    DAOResult<std::vector<UserEntity>> batchResult(true);
+    if (!missing.empty()) {
+        batchResult = m_userDao.batchGetUserInfo(missing, ReadRoute::PRIMARY);
+        if (!batchResult.isSuccess()) {
+            return ManagerResult<std::vector<UserEntity>>(ResultCode::DATABASE_ERROR, batchResult.getMessage());
+        }
+        cache->putMany(*batchResult.getData());
+        loaded.reserve(batchResult.getData()->size());
+        for (auto& user : *batchResult.getData()) {
+            loaded[user.userId] = &user;
+        }
     }
     
-    return ManagerResult<std::vector<UserEntity>>(ResultCode::SUCCESS, "User information retrieved in batch successfully", result.getData());
-} 
\ No newline at end of file
+    // Ids that exist nowhere are left out
+    auto users = std::make_shared<std::vector<UserEntity>>();
+    users->reserve(ids.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (slots[i]) {
+            users->push_back(std::move(*slots[i]));
+            continue;
+        }
+        auto it = loaded.find(ids[i]);
+        if (it != loaded.end()) {
+            users->push_back(std::move(*it->second));
+        }
+    }
+    
+    return ManagerResult<std::vector<UserEntity>>(ResultCode::SUCCESS, "User information retrieved in batch successfully", users);
+}
@@ -93,7 +93,7 @@ public:
     ManagerResult<std::vector<UserEntity>> getFriendList(int64_t userId);
     
     // 更新用户状态
-    ManagerResult<void> updateUserStatus(int64_t userId, const std::string& status);
+    ManagerResult<void> updateUserStatus(int64_t userId, UserStatus status);
     
     // 添加好友
     ManagerResult<void> addFriend(int64_t userId, int64_t friendId);
@@ -101,7 +101,8 @@ public:
     // 删除好友
     ManagerResult<void> removeFriend(int64_t userId, int64_t friendId);
     
-    // 批量获取用户状态
+    // 批量获取用户资料：去重后先查缓存，未命中的分批查库并回填缓存
+    // 结果按参数中首次出现的顺序排列，不含密码，不存在的用户不出现在结果中
     ManagerResult<std::vector<UserEntity>> batchGetUserInfo(const std::vector<int64_t>& userIds);
 
 private:
@@ -0,0 +1,185 @@
+#include "UserWriteBehind.h"
+#include "../ConfigMgr.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    int readConfig(const char* key, int defaultValue) {
+        auto value = ConfigMgr::Inst()[WRITE_BEHIND_CONFIG_SECTION][key];
+        int result = value.empty() ? 0 : atoi(value.c_str());
+        return result > 0 ? result : defaultValue;
+    }
+}
+
+UserWriteBehind::UserWriteBehind()
+    : m_flushInterval(readConfig(WRITE_BEHIND_FLUSH_INTERVAL_KEY, WRITE_BEHIND_DEFAULT_FLUSH_INTERVAL_MS)),
+      m_batchSize(readConfig(WRITE_BEHIND_BATCH_SIZE_KEY, WRITE_BEHIND_DEFAULT_BATCH_SIZE)) {
+    m_thread = std::thread(&UserWriteBehind::run, this);
+    // 连接池关闭前先写完队列
+    gDBManager.addShutdownHook([this]() { shutdown(); });
+}
+
+UserWriteBehind::~UserWriteBehind() {
+    shutdown();
+}
+
+void UserWriteBehind::updateStatus(int64_t userId, UserStatus status) {
+    enqueue(userId, status, 0);
+}
+
+void UserWriteBehind::recordLogin(int64_t userId) {
+    auto now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    enqueue(userId, UserStatus::ONLINE, now);
+}
+
+void UserWriteBehind::enqueue(int64_t userId, std::optional<UserStatus> status, int64_t loginTime) {
+    bool full = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& pending = m_pending[userId];
+        if (status) {
+            pending.status = status;
+        }
+        if (loginTime != 0) {
+            pending.loginTime = loginTime;
+        }
+        full = m_pending.size() >= m_batchSize;
+    }
+    m_enqueued.fetch_add(1, std::memory_order_relaxed);
+    // 积累够一批立即写入，否则等定时器
+    if (full) {
+        m_cond.notify_one();
+    }
+}
+
+void UserWriteBehind::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stop) {
+            return;
+        }
+        m_stop = true;
+    }
+    m_cond.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void UserWriteBehind::run() {
+    std::unordered_map<int64_t, PendingUpdate> updates;
+    bool stopping = false;
+    while (!stopping) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            // 退避期间积累够一批也不提前写，等到重试时间
+            auto now = std::chrono::steady_clock::now();
+            bool backingOff = m_retryAt > now;
+            auto wakeAt = std::max(now + m_flushInterval, m_retryAt);
+            m_cond.wait_until(lock, wakeAt, [this, backingOff] {
+                return m_stop || (!backingOff && m_pending.size() >= m_batchSize);
+            });
+            updates.swap(m_pending);
+            stopping = m_stop;
+        }
+        mergeRetries(updates);
+        flush(updates);
+        updates.clear();
+    }
+    
+    // 停止前写入失败的更新再重试一次，仍然失败的丢弃
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        updates.swap(m_pending);
+    }
+    mergeRetries(updates);
+    flush(updates);
+    if (!m_retry.empty()) {
+        std::cerr << "Dropping " << m_retry.size() << " deferred user updates on shutdown" << std::endl;
+        m_dropped.fetch_add(m_retry.size(), std::memory_order_relaxed);
+        m_retry.clear();
+    }
+}
+
+void UserWriteBehind::mergeRetries(std::unordered_map<int64_t, PendingUpdate>& updates) {
+    for (auto& entry : m_retry) {
+        auto& update = updates[entry.first];
+        if (!update.status) {
+            update.status = entry.second.status;
+        }
+        if (update.loginTime == 0) {
+            update.loginTime = entry.second.loginTime;
+        }
+        update.attempts = entry.second.attempts;
+    }
+    m_retry.clear();
+}
+
+void UserWriteBehind::flush(std::unordered_map<int64_t, PendingUpdate>& updates) {
+    std::vector<std::pair<int64_t, UserStatus>> statusUpdates;
+    std::vector<std::pair<int64_t, int64_t>> loginUpdates;
+    std::unordered_map<int64_t, PendingUpdate> chunk;
+    
+    auto it = updates.begin();
+    while (it != updates.end()) {
+        statusUpdates.clear();
+        loginUpdates.clear();
+        chunk.clear();
+        // 每批最多m_batchSize个用户
+        for (; it != updates.end() && chunk.size() < m_batchSize; ++it) {
+            if (it->second.status) {
+                statusUpdates.emplace_back(it->first, *it->second.status);
+            }
+            if (it->second.loginTime != 0) {
+                loginUpdates.emplace_back(it->first, it->second.loginTime);
+            }
+            chunk.emplace(it->first, it->second);
+        }
+        
+        auto result = m_userDao.batchUpdateUsers(statusUpdates, loginUpdates);
+        m_batches.fetch_add(1, std::memory_order_relaxed);
+        if (result.isSuccess()) {
+            m_flushedRows.fetch_add(chunk.size(), std::memory_order_relaxed);
+            m_backoff = std::chrono::milliseconds(0);
+        } else {
+            m_failures.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "Deferred user updates failed (" << chunk.size() << " users): "
+                      << result.getMessage() << std::endl;
+            requeue(chunk);
+        }
+    }
+}
+
+void UserWriteBehind::requeue(const std::unordered_map<int64_t, PendingUpdate>& updates) {
+    uint64_t dropped = 0;
+    for (auto& entry : updates) {
+        // 多半是数据本身写不进去，继续重试只会让队列越来越长
+        if (entry.second.attempts + 1 >= WRITE_BEHIND_MAX_ATTEMPTS) {
+            dropped++;
+            continue;
+        }
+        auto& retry = m_retry[entry.first];
+        retry = entry.second;
+        retry.attempts++;
+    }
+    if (dropped > 0) {
+        std::cerr << "Dropping " << dropped << " deferred user updates after "
+                  << WRITE_BEHIND_MAX_ATTEMPTS << " attempts" << std::endl;
+        m_dropped.fetch_add(dropped, std::memory_order_relaxed);
+    }
+    
+    m_backoff = m_backoff.count() == 0 ? m_flushInterval
+        : std::min(m_backoff * 2, std::chrono::milliseconds(WRITE_BEHIND_MAX_BACKOFF_MS));
+    m_retryAt = std::chrono::steady_clock::now() + m_backoff;
+}
+
+WriteBehindStats UserWriteBehind::getStats() const {
+    return WriteBehindStats{
+        m_enqueued.load(std::memory_order_relaxed),
+        m_flushedRows.load(std::memory_order_relaxed),
+        m_batches.load(std::memory_order_relaxed),
+        m_failures.load(std::memory_order_relaxed),
+        m_dropped.load(std::memory_order_relaxed)
+    };
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "UserDAO.h"
+#include "../Singleton.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+// 写入统计，enqueued / flushedRows 即合并系数
+struct WriteBehindStats {
+    uint64_t enqueued;      // 入队的更新次数
+    uint64_t flushedRows;   // 实际写入数据库的用户行数
+    uint64_t batches;       // 执行的批次数
+    uint64_t failures;      // 写入失败的批次数
+    uint64_t dropped;       // 多次写入失败后丢弃的用户更新数
+};
+
+// 用户状态和最后登录时间的延迟写入：调用线程只负责入队，
+// 同一用户的多次更新在队列中合并(状态以最后一次为准)，
+// 后台线程按定时或积累数量批量写入，每批合并成多行UPDATE。
+// 写入失败的更新移到重试队列，按指数退避的间隔重试，退避期间新的更新也不写入；
+// 同一个更新失败WRITE_BEHIND_MAX_ATTEMPTS次后丢弃。
+// DBManager::shutdownDBConnectionPool关闭连接池前会先写完队列，
+// 异常退出时最多丢失一个写入间隔内的更新。
+class UserWriteBehind : public Singleton<UserWriteBehind> {
+    friend class Singleton<UserWriteBehind>;
+public:
+    ~UserWriteBehind();
+    
+    // 更新用户状态
+    void updateStatus(int64_t userId, UserStatus status);
+    
+    // 记录一次登录：状态置为online并刷新最后登录时间
+    void recordLogin(int64_t userId);
+    
+    // 写出所有待写入的更新并停止后台线程
+    void shutdown();
+    
+    WriteBehindStats getStats() const;
+
+private:
+    // status为空表示不更新状态，loginTime为0表示不更新登录时间，attempts为已经失败的次数
+    struct PendingUpdate {
+        std::optional<UserStatus> status;
+        int64_t loginTime = 0;
+        int attempts = 0;
+    };
+    
+    UserWriteBehind();
+    void enqueue(int64_t userId, std::optional<UserStatus> status, int64_t loginTime);
+    void run();
+    void flush(std::unordered_map<int64_t, PendingUpdate>& updates);
+    // 重试队列并入本次要写的更新，新入队的值优先
+    void mergeRetries(std::unordered_map<int64_t, PendingUpdate>& updates);
+    // 写入失败的更新移到重试队列并推迟下次写入，失败次数用完的丢弃
+    void requeue(const std::unordered_map<int64_t, PendingUpdate>& updates);
+    
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::unordered_map<int64_t, PendingUpdate> m_pending;
+    // 以下只由后台线程访问。重试队列不计入立即写入的数量
+    std::unordered_map<int64_t, PendingUpdate> m_retry;
+    std::chrono::milliseconds m_backoff{ 0 };
+    std::chrono::steady_clock::time_point m_retryAt{};
+    bool m_stop = false;
+    std::chrono::milliseconds m_flushInterval;
+    size_t m_batchSize;
+    std::thread m_thread;
+    UserDAO m_userDao;
+    
+    std::atomic<uint64_t> m_enqueued{ 0 };
+    std::atomic<uint64_t> m_flushedRows{ 0 };
+    std::atomic<uint64_t> m_batches{ 0 };
+    std::atomic<uint64_t> m_failures{ 0 };
+    std::atomic<uint64_t> m_dropped{ 0 };
+};
@@ -27,6 +27,8 @@ CREATE TABLE users (
     status ENUM('online', 'offline', 'away') NOT NULL DEFAULT 'offline',
     create_time DATETIME NOT NULL,
     last_login_time DATETIME NOT NULL,
+    -- 资料或状态的最后变更时间，好友列表增量同步用它判断哪些好友有变化
+    update_time TIMESTAMP(3) NOT NULL DEFAULT CURRENT_TIMESTAMP(3) ON UPDATE CURRENT_TIMESTAMP(3),
     PRIMARY KEY (user_id),
     UNIQUE KEY (username),
     UNIQUE KEY (email)
@@ -38,7 +40,11 @@ CREATE TABLE IF NOT EXISTS friendships (
     user_id INT NOT NULL,
     friend_id INT NOT NULL,
     establish_time DATETIME NOT NULL,
+    -- 删除好友只做标记，增量同步才能告诉客户端哪些好友被删除了
+    deleted TINYINT(1) NOT NULL DEFAULT 0,
+    update_time TIMESTAMP(3) NOT NULL DEFAULT CURRENT_TIMESTAMP(3) ON UPDATE CURRENT_TIMESTAMP(3),
     PRIMARY KEY (id),
+    -- 好友列表按(user_id, friend_id)做keyset分页
     UNIQUE KEY (user_id, friend_id),
     FOREIGN KEY (user_id) REFERENCES users(user_id) ON DELETE CASCADE,
     FOREIGN KEY (friend_id) REFERENCES users(user_id) ON DELETE CASCADE
@@ -174,4 +180,9 @@ BEGIN
     INSERT INTO group_members (group_id, user_id, role, join_time)
     VALUES (p_group_id, p_creator_id, 'owner', NOW());
 END //
-DELIMITER ; 
\ No newline at end of file
+DELIMITER ;
+
+-- 已有数据库升级到好友列表分页/增量同步版本
+-- ALTER TABLE users ADD COLUMN update_time TIMESTAMP(3) NOT NULL DEFAULT CURRENT_TIMESTAMP(3) ON UPDATE CURRENT_TIMESTAMP(3);
+-- ALTER TABLE friendships ADD COLUMN deleted TINYINT(1) NOT NULL DEFAULT 0,
+--     ADD COLUMN update_time TIMESTAMP(3) NOT NULL DEFAULT CURRENT_TIMESTAMP(3) ON UPDATE CURRENT_TIMESTAMP(3);
@@ -1,5 +1,7 @@
 -- 为您的即时通讯系统创建的MySQL存储过程
 -- 统一使用utf8mb4_unicode_ci排序规则，确保字符集兼容性
+-- 返回用户资料的存储过程列顺序固定(与UserDAO.cpp中的UserColumn一致)，时间为Unix时间戳，
+-- 网关按列序号读取，修改列表时两边要同步
 
 -- 添加用户存储过程
 DROP PROCEDURE IF EXISTS proc_add_user;
@@ -25,7 +27,9 @@ CREATE PROCEDURE proc_find_user_by_username(
     IN p_username VARCHAR(50) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci
 )
 BEGIN
-    SELECT * FROM users WHERE username = p_username COLLATE utf8mb4_unicode_ci;
+    SELECT user_id, username, password, nickname, avatar, email, status,
+           UNIX_TIMESTAMP(create_time) AS create_time, UNIX_TIMESTAMP(last_login_time) AS last_login_time
+    FROM users WHERE username = p_username COLLATE utf8mb4_unicode_ci;
 END$$
 DELIMITER ;
 
@@ -36,7 +40,9 @@ CREATE PROCEDURE proc_find_user_by_id(
     IN p_user_id BIGINT
 )
 BEGIN
-    SELECT * FROM users WHERE user_id = p_user_id;
+    SELECT user_id, username, password, nickname, avatar, email, status,
+           UNIX_TIMESTAMP(create_time) AS create_time, UNIX_TIMESTAMP(last_login_time) AS last_login_time
+    FROM users WHERE user_id = p_user_id;
 END$$
 DELIMITER ;
 
@@ -70,10 +76,11 @@ CREATE PROCEDURE proc_get_friend_list(
     IN p_user_id BIGINT
 )
 BEGIN
-    SELECT u.* 
+    SELECT u.user_id, u.username, u.password, u.nickname, u.avatar, u.email, u.status,
+           UNIX_TIMESTAMP(u.create_time) AS create_time, UNIX_TIMESTAMP(u.last_login_time) AS last_login_time
     FROM users u
     INNER JOIN friendships f ON u.user_id = f.friend_id
-    WHERE f.user_id = p_user_id;
+    WHERE f.user_id = p_user_id AND f.deleted = 0;
 END$$
 DELIMITER ;
 
@@ -92,6 +99,23 @@ BEGIN
 END$$
 DELIMITER ;
 
+-- 登录存储过程：校验密码并返回完整用户信息，一次往返完成
+-- 用户名或密码错误时返回空结果集
+DROP PROCEDURE IF EXISTS proc_login_user;
+DELIMITER $$
+CREATE PROCEDURE proc_login_user(
+    IN p_username VARCHAR(50) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci,
+    IN p_password VARCHAR(100) CHARACTER SET utf8mb4 COLLATE utf8mb4_unicode_ci
+)
+BEGIN
+    SELECT user_id, username, password, nickname, avatar, email, status,
+           UNIX_TIMESTAMP(create_time) AS create_time, UNIX_TIMESTAMP(last_login_time) AS last_login_time
+    FROM users
+    WHERE username = p_username COLLATE utf8mb4_unicode_ci
+    AND password = p_password COLLATE utf8mb4_unicode_ci;
+END$$
+DELIMITER ;
+
 -- 添加好友关系存储过程（使用事务确保双向关系）
 DROP PROCEDURE IF EXISTS proc_add_friend;
 DELIMITER $$
@@ -105,19 +129,21 @@ BEGIN
     -- 检查是否已经是好友
     SELECT COUNT(*) INTO existing_count
     FROM friendships
-    WHERE user_id = p_user_id AND friend_id = p_friend_id;
+    WHERE user_id = p_user_id AND friend_id = p_friend_id AND deleted = 0;
     
     IF existing_count = 0 THEN
         -- 开始事务
         START TRANSACTION;
         
-        -- 添加正向好友关系
+        -- 添加正向好友关系，之前删除过的恢复标记
         INSERT INTO friendships (user_id, friend_id, establish_time)
-        VALUES (p_user_id, p_friend_id, NOW());
+        VALUES (p_user_id, p_friend_id, NOW())
+        ON DUPLICATE KEY UPDATE deleted = 0, establish_time = NOW();
         
         -- 添加反向好友关系
         INSERT INTO friendships (user_id, friend_id, establish_time)
-        VALUES (p_friend_id, p_user_id, NOW());
+        VALUES (p_friend_id, p_user_id, NOW())
+        ON DUPLICATE KEY UPDATE deleted = 0, establish_time = NOW();
         
         -- 提交事务
         COMMIT;
@@ -136,13 +162,13 @@ BEGIN
     -- 开始事务
     START TRANSACTION;
     
-    -- 删除正向好友关系
-    DELETE FROM friendships
-    WHERE user_id = p_user_id AND friend_id = p_friend_id;
+    -- 删除正向好友关系(标记删除，增量同步需要知道删除了谁)
+    UPDATE friendships SET deleted = 1
+    WHERE user_id = p_user_id AND friend_id = p_friend_id AND deleted = 0;
     
     -- 删除反向好友关系
-    DELETE FROM friendships
-    WHERE user_id = p_friend_id AND friend_id = p_user_id;
+    UPDATE friendships SET deleted = 1
+    WHERE user_id = p_friend_id AND friend_id = p_user_id AND deleted = 0;
     
     -- 提交事务
     COMMIT;
@@ -150,6 +176,7 @@ END$$
 DELIMITER ;
 
 -- 批量获取用户信息存储过程
+-- UserDAO::batchGetUserInfo已改为分批的参数化IN查询，不再调用，保留给旧版本网关
 DROP PROCEDURE IF EXISTS proc_batch_get_user_info;
 DELIMITER $$
 CREATE PROCEDURE proc_batch_get_user_info(
@@ -326,23 +353,26 @@ BEGIN
         -- 好友不存在
         SET p_result = -2;
     ELSE
-        -- 检查是否已经是好友
+        -- 检查是否已经是好友（已删除的关系不算）
         SELECT COUNT(*) INTO v_exists
         FROM friendships
-        WHERE (user_id = p_user_id AND friend_id = p_friend_id)
-           OR (user_id = p_friend_id AND friend_id = p_user_id);
+        WHERE ((user_id = p_user_id AND friend_id = p_friend_id)
+           OR (user_id = p_friend_id AND friend_id = p_user_id))
+          AND deleted = 0;
         
         IF v_exists > 0 THEN
             -- 已经是好友
             SET p_result = -1;
         ELSE
-            -- 添加好友关系
+            -- 添加好友关系，删除过的关系恢复
             INSERT INTO friendships (user_id, friend_id, establish_time)
-            VALUES (p_user_id, p_friend_id, NOW());
+            VALUES (p_user_id, p_friend_id, NOW())
+            ON DUPLICATE KEY UPDATE deleted = 0, establish_time = NOW();
             
             -- 也添加反向的关系
             INSERT INTO friendships (user_id, friend_id, establish_time)
-            VALUES (p_friend_id, p_user_id, NOW());
+            VALUES (p_friend_id, p_user_id, NOW())
+            ON DUPLICATE KEY UPDATE deleted = 0, establish_time = NOW();
             
             SET p_result = 0;
         END IF;
@@ -358,10 +388,11 @@ CREATE PROCEDURE sp_remove_friend(
     IN p_friend_id INT
 )
 BEGIN
-    -- 删除好友关系（双向）
-    DELETE FROM friendships
-    WHERE (user_id = p_user_id AND friend_id = p_friend_id)
-       OR (user_id = p_friend_id AND friend_id = p_user_id);
+    -- 删除好友关系（双向），只做标记，增量同步才能返回被删除的好友
+    UPDATE friendships SET deleted = 1
+    WHERE ((user_id = p_user_id AND friend_id = p_friend_id)
+       OR (user_id = p_friend_id AND friend_id = p_user_id))
+      AND deleted = 0;
 END //
 DELIMITER ;
 
@@ -376,7 +407,7 @@ BEGIN
            u.last_login_time, f.establish_time
     FROM users u
     JOIN friendships f ON u.user_id = f.friend_id
-    WHERE f.user_id = p_user_id;
+    WHERE f.user_id = p_user_id AND f.deleted = 0;
 END //
 DELIMITER ;
 
@@ -0,0 +1,72 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <boost/asio.hpp>
+
+//网关每秒能接受的新连接数。每个连接只发一个GET /get_test请求，读完应答后关闭，
+//开销主要在accept和连接在线程间的交接上。
+//分别用[GateServer] ReusePort = false和true启动网关，对比单acceptor和每个io_context各一个acceptor。
+//用法：AcceptBench [host] [port] [threads] [seconds]
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+
+int main(int argc, char* argv[]) {
+    std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+    std::string port = argc > 2 ? argv[2] : "8080";
+    int threads = argc > 3 ? std::stoi(argv[3]) : 32;
+    int seconds = argc > 4 ? std::stoi(argv[4]) : 10;
+
+    net::io_context resolverContext;
+    auto endpoints = tcp::resolver(resolverContext).resolve(host, port);
+    const std::string request = "GET /get_test HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n\r\n";
+
+    std::atomic<bool> stop{ false };
+    std::atomic<uint64_t> connections{ 0 };
+    std::atomic<uint64_t> errors{ 0 };
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&] {
+            net::io_context ioc;
+            std::vector<char> buffer(4096);
+            while (!stop.load(std::memory_order_relaxed)) {
+                boost::system::error_code ec;
+                tcp::socket socket(ioc);
+                net::connect(socket, endpoints, ec);
+                if (!ec) {
+                    net::write(socket, net::buffer(request), ec);
+                }
+                //读到服务端关闭连接为止
+                while (!ec) {
+                    socket.read_some(net::buffer(buffer), ec);
+                }
+                if (ec == net::error::eof) {
+                    connections.fetch_add(1, std::memory_order_relaxed);
+                }
+                else {
+                    errors.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t last = 0;
+    for (int i = 0; i < seconds; ++i) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        uint64_t now = connections.load();
+        std::cout << "second " << i + 1 << ": " << now - last << " conn/s" << std::endl;
+        last = now;
+    }
+    stop = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "total: " << connections.load() << " connections, " << errors.load() << " errors, "
+              << connections.load() / elapsed.count() << " conn/s with " << threads << " client threads" << std::endl;
+    return 0;
+}
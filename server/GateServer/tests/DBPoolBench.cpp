@@ -0,0 +1,107 @@
+#include "../db/DBConnectionPool.h"
+#include <algorithm>
+
+//多线程同时借还连接时DBConnectionPool::getConnection的耗时分布。
+//第一轮按默认的ValidationWindow借出(最近确认过可用的连接不再ping)，第二轮每次借出都ping，
+//对比可以看出借连接本身的开销和一次数据库往返的差距。
+//用法：DBPoolBench host:port user password schema [threads] [seconds] [maxSize]
+namespace {
+    struct RoundResult {
+        std::vector<int64_t> latenciesNs;
+        uint64_t failures = 0;
+        double seconds = 0;
+    };
+
+    RoundResult RunRound(DBConnectionPool& pool, int threads, int seconds) {
+        std::atomic<bool> stop{ false };
+        std::vector<std::vector<int64_t>> perThread(threads);
+        std::atomic<uint64_t> failures{ 0 };
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < threads; ++i) {
+            workers.emplace_back([&, i] {
+                auto& latencies = perThread[i];
+                while (!stop.load(std::memory_order_relaxed)) {
+                    auto begin = std::chrono::steady_clock::now();
+                    std::shared_ptr<ConnectionWrapper> conn;
+                    try {
+                        conn = pool.getConnection();
+                    }
+                    catch (const std::exception&) {
+                        //线程数超过maxSize时等待可能超时，超时和连接池关闭都抛异常
+                        failures.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    auto end = std::chrono::steady_clock::now();
+                    latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+                    //连接在这里析构，归还连接池
+                }
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        stop = true;
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        RoundResult result;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.failures = failures.load();
+        for (auto& latencies : perThread) {
+            result.latenciesNs.insert(result.latenciesNs.end(), latencies.begin(), latencies.end());
+        }
+        std::sort(result.latenciesNs.begin(), result.latenciesNs.end());
+        return result;
+    }
+
+    void Report(const char* name, const RoundResult& result) {
+        auto& latencies = result.latenciesNs;
+        if (latencies.empty()) {
+            std::cout << name << ": no connection acquired, " << result.failures << " failures" << std::endl;
+            return;
+        }
+        auto percentile = [&](double p) {
+            return latencies[std::min(latencies.size() - 1, static_cast<size_t>(latencies.size() * p))] / 1000.0;
+        };
+        std::cout << name << ": " << latencies.size() / result.seconds << " acquires/s"
+                  << ", p50 " << percentile(0.50) << "us"
+                  << ", p99 " << percentile(0.99) << "us"
+                  << ", max " << latencies.back() / 1000.0 << "us"
+                  << ", " << result.failures << " failures" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 5) {
+        std::cout << "usage: DBPoolBench host:port user password schema [threads] [seconds] [maxSize]" << std::endl;
+        return 1;
+    }
+    int threads = argc > 5 ? std::stoi(argv[5]) : 64;
+    int seconds = argc > 6 ? std::stoi(argv[6]) : 5;
+
+    DBPoolConfig config;
+    config.host = argv[1];
+    config.user = argv[2];
+    config.password = argv[3];
+    config.database = argv[4];
+    config.maxSize = argc > 7 ? std::stoi(argv[7]) : threads;
+    config.initialSize = config.maxSize;
+    config.minSize = config.maxSize;
+
+    const std::pair<const char*, int> rounds[] = {
+        { "validation window", DB_DEFAULT_VALIDATION_WINDOW },
+        { "ping every borrow", 0 },
+    };
+    for (auto& round : rounds) {
+        config.validationWindow = round.second;
+        DBConnectionPool pool;
+        if (!pool.init(config)) {
+            std::cout << "failed to connect to " << config.host << std::endl;
+            return 1;
+        }
+        Report(round.first, RunRound(pool, threads, seconds));
+        pool.shutdown();
+    }
+    std::cout << threads << " threads, maxSize " << config.maxSize << std::endl;
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "FakeVarifyServer.h"
+#include "../const.h"
+#include <thread>
+
+namespace {
+    //Hang模式最多等这么久，防止客户端没有设置截止时间时测试卡住
+    const auto HANG_LIMIT = std::chrono::seconds(10);
+}
+
+FakeVarifyServer::FakeVarifyServer(int port) {
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("127.0.0.1:" + std::to_string(port), grpc::InsecureServerCredentials());
+    builder.RegisterService(this);
+    server_ = builder.BuildAndStart();
+    if (!server_) {
+        throw std::runtime_error("fake VarifyServer failed to listen on port " + std::to_string(port));
+    }
+}
+
+FakeVarifyServer::~FakeVarifyServer() {
+    //还在等待的请求会被取消，Wait随之返回
+    server_->Shutdown(std::chrono::system_clock::now() + std::chrono::seconds(1));
+}
+
+void FakeVarifyServer::SetMode(Mode mode, std::chrono::milliseconds delay) {
+    delayMs_.store(delay.count());
+    mode_.store(mode);
+}
+
+void FakeVarifyServer::Reset() {
+    requests_.store(0);
+    std::lock_guard<std::mutex> lock(mutex_);
+    requestIds_.clear();
+}
+
+std::unordered_set<std::string> FakeVarifyServer::RequestIds() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requestIds_;
+}
+
+bool FakeVarifyServer::Wait(grpc::ServerContext* context, std::chrono::steady_clock::time_point until) {
+    while (std::chrono::steady_clock::now() < until) {
+        if (context->IsCancelled()) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return true;
+}
+
+grpc::Status FakeVarifyServer::GetVarifyCode(grpc::ServerContext* context, const message::GetVarifyReq* request,
+                                             message::GetVarifyRsp* reply) {
+    requests_.fetch_add(1);
+    auto metadata = context->client_metadata().find(VARIFY_REQUEST_ID_METADATA);
+    if (metadata != context->client_metadata().end()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requestIds_.emplace(metadata->second.data(), metadata->second.size());
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    switch (mode_.load()) {
+    case Mode::Ok:
+        break;
+    case Mode::Slow:
+        if (!Wait(context, now + std::chrono::milliseconds(delayMs_.load()))) {
+            return grpc::Status::CANCELLED;
+        }
+        break;
+    case Mode::Unavailable:
+        return grpc::Status(grpc::StatusCode::UNAVAILABLE, "fake VarifyServer unavailable");
+    case Mode::Hang:
+        Wait(context, now + HANG_LIMIT);
+        return grpc::Status::CANCELLED;
+    }
+
+    reply->set_error(ErrorCodes::Success);
+    reply->set_email(request->email());
+    reply->set_code("123456");
+    return grpc::Status::OK;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <grpcpp/grpcpp.h>
+#include "../message.grpc.pb.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+//进程内的假VarifyServer，不连Redis也不发邮件，供网关验证码客户端的测试使用。
+//应答方式可以在运行时切换：正常应答、延迟应答、返回UNAVAILABLE、一直不应答直到请求被取消或超时。
+//记录收到的请求数和不同的请求id数，用来检查重试和对冲请求是否共用同一个请求id。
+class FakeVarifyServer final : public message::VarifyService::Service
+{
+public:
+    enum class Mode {
+        Ok,
+        Slow,           //等待delay后正常应答，请求被取消时提前返回
+        Unavailable,
+        Hang,
+    };
+
+    //在127.0.0.1:port上启动服务
+    explicit FakeVarifyServer(int port);
+    ~FakeVarifyServer() override;
+
+    void SetMode(Mode mode, std::chrono::milliseconds delay = std::chrono::milliseconds(0));
+
+    //清空计数
+    void Reset();
+
+    int Requests() const {
+        return requests_.load();
+    }
+
+    //收到过的请求id，多个实例的结果合并后可以和调用次数比较
+    std::unordered_set<std::string> RequestIds();
+
+    grpc::Status GetVarifyCode(grpc::ServerContext* context, const message::GetVarifyReq* request,
+                               message::GetVarifyRsp* reply) override;
+
+private:
+    //等待到期或请求被取消，被取消返回false
+    bool Wait(grpc::ServerContext* context, std::chrono::steady_clock::time_point until);
+
+    std::unique_ptr<grpc::Server> server_;
+    std::atomic<Mode> mode_{ Mode::Ok };
+    std::atomic<int64_t> delayMs_{ 0 };
+    std::atomic<int> requests_{ 0 };
+    std::mutex mutex_;
+    std::unordered_set<std::string> requestIds_;
+};
@@ -0,0 +1,62 @@
+#include "../JsonCodec.h"
+#include <json/json.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+//对比/login请求的解析和应答的编码：JsonReader/JsonWriter与原来的jsoncpp写法
+namespace {
+    const std::string LOGIN_BODY = R"({"username":"alice_in_wonderland","password":"0123456789abcdef0123456789abcdef"})";
+    constexpr int ITERATIONS = 1000000;
+
+    //防止编译器把结果优化掉
+    volatile std::size_t sink = 0;
+
+    template <typename Func>
+    void Run(const char* name, Func&& func) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; ++i) {
+            func();
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+        std::cout << name << ": " << elapsed.count() / ITERATIONS << " ns/op" << std::endl;
+    }
+}
+
+int main() {
+    Run("jsoncpp   login", [] {
+        Json::Reader reader;
+        Json::Value src;
+        reader.parse(LOGIN_BODY, src);
+        auto username = src["username"].asString();
+        auto password = src["password"].asString();
+
+        Json::Value root;
+        root["error"] = 0;
+        root["uid"] = 10001;
+        root["username"] = username;
+        root["email"] = "alice@example.com";
+        root["token"] = "3f2b8c1e-6a4d-4c3b-9a8e-1d2c3b4a5f6e";
+        sink = sink + root.toStyledString().size() + password.size();
+    });
+
+    Run("JsonCodec login", [] {
+        std::string username, password;
+        JsonReader reader(LOGIN_BODY);
+        reader.ForEachField([&](std::string_view key) {
+            if (key == "username") reader.ReadString(username);
+            else if (key == "password") reader.ReadString(password);
+        });
+
+        std::string body;
+        JsonWriter(body).BeginObject()
+            .Key("error").Int(0)
+            .Key("uid").Int(10001)
+            .Key("username").String(username)
+            .Key("email").String("alice@example.com")
+            .Key("token").String("3f2b8c1e-6a4d-4c3b-9a8e-1d2c3b4a5f6e")
+            .EndObject();
+        sink = sink + body.size() + password.size();
+    });
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include "../JsonCodec.h"
+#include <json/json.h>
+#include <iostream>
+#include <memory>
+
+//JsonReader/JsonWriter的正确性检查：解析结果与jsoncpp对照，编码结果能被jsoncpp还原
+namespace {
+    int failures = 0;
+
+    void Check(bool ok, const char* what) {
+        if (!ok) {
+            std::cout << "FAIL: " << what << std::endl;
+            ++failures;
+        }
+    }
+
+    bool ParseWithJsoncpp(const std::string& text, Json::Value& root) {
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        std::string errors;
+        return reader->parse(text.data(), text.data() + text.size(), &root, &errors);
+    }
+
+    void TestReadFields() {
+        std::string username, password;
+        int64_t uid = 0;
+        JsonReader reader(R"( { "username" : "alice", "uid": -42,
+            "nested": {"a": [1, {"b": "}"}], "c": "\"]"}, "flag": true,
+            "password": "p\"w\\d" } )");
+        bool ok = reader.ForEachField([&](std::string_view key) {
+            if (key == "username") reader.ReadString(username);
+            else if (key == "password") reader.ReadString(password);
+            else if (key == "uid") reader.ReadInt(uid);
+        });
+        Check(ok, "read: parse object");
+        Check(username == "alice", "read: string field");
+        Check(password == "p\"w\\d", "read: escaped string field");
+        Check(uid == -42, "read: int field");
+    }
+
+    void TestReadUnicode() {
+        std::string text = R"({"name":"你好 😀\n\t\/"})";
+        std::string name;
+        JsonReader reader(text);
+        bool ok = reader.ForEachField([&](std::string_view key) {
+            if (key == "name") reader.ReadString(name);
+        });
+        Json::Value root;
+        Check(ok && ParseWithJsoncpp(text, root), "unicode: parse");
+        Check(name == root["name"].asString(), "unicode: same as jsoncpp");
+    }
+
+    void TestReadEscapedKey() {
+        //key带转义字符时要先还原再比较
+        std::string value, quoted;
+        JsonReader reader(R"({"em\u0061il":"a@b.c","a\"b":"q"})");
+        bool ok = reader.ForEachField([&](std::string_view key) {
+            if (key == "email") reader.ReadString(value);
+            else if (key == "a\"b") reader.ReadString(quoted);
+        });
+        Check(ok && value == "a@b.c", "read: escaped key");
+        Check(quoted == "q", "read: escaped quote in key");
+    }
+
+    void TestReadErrors() {
+        const char* bad[] = {
+            "",
+            "[]",
+            "{",
+            R"({"a":)",
+            R"({"a":1,)",
+            R"({"a" 1})",
+            R"({"a":"unterminated})",
+            R"({"a":{"b":1})",
+            R"({"a":1 "b":2})",
+        };
+        for (auto text : bad) {
+            JsonReader reader(text);
+            Check(!reader.ForEachField([](std::string_view) {}), text);
+        }
+
+        //字段类型不对时读取失败，整个解析失败
+        std::string s;
+        int64_t n = 0;
+        JsonReader strAsInt(R"({"uid":"12"})");
+        Check(!strAsInt.ForEachField([&](std::string_view) { strAsInt.ReadInt(n); }), "read: string as int");
+        JsonReader intAsStr(R"({"email":12})");
+        Check(!intAsStr.ForEachField([&](std::string_view) { intAsStr.ReadString(s); }), "read: int as string");
+        JsonReader badEscape(R"({"email":"\x"})");
+        Check(!badEscape.ForEachField([&](std::string_view) { badEscape.ReadString(s); }), "read: bad escape");
+
+        JsonReader empty("{}");
+        Check(empty.ForEachField([](std::string_view) {}), "read: empty object");
+    }
+
+    void TestWriteRoundTrip() {
+        std::string control = "tab\tnl\ncr\rquote\"back\\bell\x01 \xe4\xbd\xa0";
+        std::string body;
+        JsonWriter(body).BeginObject()
+            .Key("error").Int(0)
+            .Key("min").Int(INT64_MIN)
+            .Key("max").UInt(UINT64_MAX)
+            .Key("ok").Bool(true)
+            .Key("text").String(control)
+            .Key("k\"ey").String("")
+            .Key("list").BeginArray()
+                .BeginObject().Key("uid").Int(1).EndObject()
+                .BeginObject().Key("uid").Int(2).EndObject()
+                .Int(3)
+            .EndArray()
+            .Key("empty").BeginArray().EndArray()
+            .EndObject();
+
+        Json::Value root;
+        Check(ParseWithJsoncpp(body, root), "write: jsoncpp parses output");
+        Check(root["error"].asInt() == 0, "write: int");
+        Check(root["min"].asInt64() == INT64_MIN, "write: int64 min");
+        Check(root["max"].asUInt64() == UINT64_MAX, "write: uint64 max");
+        Check(root["ok"].asBool(), "write: bool");
+        Check(root["text"].asString() == control, "write: escaped string");
+        Check(root.isMember("k\"ey"), "write: escaped key");
+        Check(root["list"].size() == 3 && root["list"][1]["uid"].asInt() == 2 && root["list"][2].asInt() == 3,
+            "write: array");
+        Check(root["empty"].isArray() && root["empty"].empty(), "write: empty array");
+
+        //JsonWriter的输出也能被JsonReader读回
+        std::string text;
+        JsonReader reader(body);
+        bool ok = reader.ForEachField([&](std::string_view key) {
+            if (key == "text") reader.ReadString(text);
+        });
+        Check(ok && text == control, "write: JsonReader round trip");
+    }
+}
+
+int main() {
+    TestReadFields();
+    TestReadUnicode();
+    TestReadEscapedKey();
+    TestReadErrors();
+    TestWriteRoundTrip();
+    if (failures) {
+        std::cout << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "JsonCodecTest passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "../RedisMgr.h"
+#include <fstream>
+
+//N个key的读写：RedisMgr::Exec(RedisBatch)一次往返流水线执行，与N次单独的Get/Set对比。
+//RedisMgr从工作目录下的config.ini读取地址，所以先在临时目录里写一份config.ini。
+//用法：RedisBatchBench host port [password] [rounds]
+namespace {
+    const std::string KEY_PREFIX = "bench:redisbatch:";
+
+    void WriteConfig(const std::string& host, const std::string& port, const std::string& password) {
+        std::ofstream out("config.ini", std::ios::trunc);
+        out << "[" << REDIS_CONFIG_SECTION << "]\n"
+            << "Host = " << host << "\n"
+            << "Port = " << port << "\n"
+            << "Passwd = " << password << "\n"
+            << REDIS_POOL_SIZE_KEY << " = 1\n";
+    }
+
+    template <typename Func>
+    double MeasureUs(int rounds, Func&& func) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i) {
+            func();
+        }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rounds;
+    }
+
+    bool RunSize(RedisMgr& redis, size_t n, int rounds) {
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < n; ++i) {
+            keys.push_back(KEY_PREFIX + std::to_string(i));
+        }
+        const std::string value(64, 'v');
+        bool ok = true;
+        std::string out;
+
+        double setEach = MeasureUs(rounds, [&] {
+            for (auto& key : keys) {
+                ok = redis.Set(key, value) && ok;
+            }
+        });
+        double getEach = MeasureUs(rounds, [&] {
+            for (auto& key : keys) {
+                ok = redis.Get(key, out) && ok;
+            }
+        });
+
+        RedisBatch sets, gets;
+        for (auto& key : keys) {
+            sets.Add({ "SET", key, value });
+            gets.Add({ "GET", key });
+        }
+        std::vector<RedisValue> replies;
+        double setBatch = MeasureUs(rounds, [&] {
+            ok = redis.Exec(sets, replies) && ok;
+        });
+        double getBatch = MeasureUs(rounds, [&] {
+            ok = redis.Exec(gets, replies) && ok && replies.size() == n;
+        });
+
+        std::cout << "N=" << n
+                  << "  SET: " << setEach << "us per-call, " << setBatch << "us batch"
+                  << "  GET: " << getEach << "us per-call, " << getBatch << "us batch" << std::endl;
+
+        RedisBatch dels;
+        for (auto& key : keys) {
+            dels.Add({ "DEL", key });
+        }
+        redis.Exec(dels, replies);
+        return ok;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cout << "usage: RedisBatchBench host port [password] [rounds]" << std::endl;
+        return 1;
+    }
+    std::string password = argc > 3 ? argv[3] : "";
+    int rounds = argc > 4 ? std::stoi(argv[4]) : 1000;
+
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("redisbatchbench-%%%%%%");
+    boost::filesystem::create_directories(dir);
+    boost::filesystem::current_path(dir);
+    WriteConfig(argv[1], argv[2], password);
+
+    auto redis = RedisMgr::GetInstance();
+    bool ok = true;
+    for (size_t n : { 1, 10, 100 }) {
+        ok = RunSize(*redis, n, rounds) && ok;
+    }
+    redis->Close();
+
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(dir, ec);
+    if (!ok) {
+        std::cout << "some Redis commands failed, check the address and password" << std::endl;
+        return 1;
+    }
+    return 0;
+}
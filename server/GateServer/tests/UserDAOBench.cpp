@@ -0,0 +1,84 @@
+#include "../db/UserDAO.h"
+#include <algorithm>
+#include <fstream>
+
+//UserDAO::findById(proc_find_user_by_id)的耗时：每次重新预处理CALL语句(StatementCacheSize = 0)
+//与使用连接上缓存的预处理语句(默认大小)对比。
+//DBManager从工作目录下的config.ini读取连接参数，所以每一轮在临时目录里写一份config.ini再重建连接池。
+//用法：UserDAOBench host port user password schema userId [iterations]
+namespace {
+    void WriteConfig(char* argv[], int statementCacheSize) {
+        std::ofstream out("config.ini", std::ios::trunc);
+        out << "[" << MYSQL_CONFIG_SECTION << "]\n"
+            << MYSQL_HOST_KEY << " = " << argv[1] << "\n"
+            << MYSQL_PORT_KEY << " = " << argv[2] << "\n"
+            << MYSQL_USER_KEY << " = " << argv[3] << "\n"
+            << MYSQL_PASSWD_KEY << " = " << argv[4] << "\n"
+            << MYSQL_SCHEMA_KEY << " = " << argv[5] << "\n"
+            << MYSQL_INITIAL_SIZE_KEY << " = 1\n"
+            << MYSQL_MIN_SIZE_KEY << " = 1\n"
+            << MYSQL_STATEMENT_CACHE_SIZE_KEY << " = " << statementCacheSize << "\n";
+    }
+
+    void RunRound(const char* name, int64_t userId, int iterations) {
+        UserDAO dao;
+        //预热：建立连接，缓存开启时顺便预处理好语句
+        for (int i = 0; i < 100; ++i) {
+            dao.findById(userId, ReadRoute::PRIMARY);
+        }
+
+        std::vector<int64_t> latenciesNs;
+        latenciesNs.reserve(iterations);
+        int found = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            auto begin = std::chrono::steady_clock::now();
+            auto result = dao.findById(userId, ReadRoute::PRIMARY);
+            latenciesNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - begin).count());
+            found += result.isSuccess() ? 1 : 0;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::sort(latenciesNs.begin(), latenciesNs.end());
+        auto percentile = [&](double p) {
+            return latenciesNs[std::min(latenciesNs.size() - 1, static_cast<size_t>(latenciesNs.size() * p))] / 1000.0;
+        };
+        std::cout << name << ": " << iterations / seconds << " calls/s"
+                  << ", p50 " << percentile(0.50) << "us"
+                  << ", p99 " << percentile(0.99) << "us"
+                  << ", " << found << "/" << iterations << " found" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 7) {
+        std::cout << "usage: UserDAOBench host port user password schema userId [iterations]" << std::endl;
+        return 1;
+    }
+    int64_t userId = std::stoll(argv[6]);
+    int iterations = argc > 7 ? std::stoi(argv[7]) : 10000;
+
+    auto dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("userdaobench-%%%%%%");
+    boost::filesystem::create_directories(dir);
+    boost::filesystem::current_path(dir);
+
+    const std::pair<const char*, int> rounds[] = {
+        { "statement cache 0", 0 },
+        { "statement cache default", DB_DEFAULT_STATEMENT_CACHE_SIZE },
+    };
+    for (auto& round : rounds) {
+        WriteConfig(argv, round.second);
+        ConfigMgr::Inst().Reload();
+        if (!gDBManager.initDBConnectionPool()) {
+            std::cout << "failed to connect to " << argv[1] << ":" << argv[2] << std::endl;
+            return 1;
+        }
+        RunRound(round.first, userId, iterations);
+        gDBManager.shutdownDBConnectionPool();
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(dir, ec);
+    return 0;
+}
@@ -0,0 +1,235 @@
+#include "FakeVarifyServer.h"
+#include "../VarifyGrpcClient.h"
+#include <functional>
+#include <thread>
+
+//验证码客户端的截止时间、重试、对冲、实例摘除和重试预算测试。
+//两个假VarifyServer监听tests/config.ini里Endpoints配置的端口，需要在tests目录下运行。
+namespace {
+    using Mode = FakeVarifyServer::Mode;
+    using std::chrono::milliseconds;
+
+    const int PORT_A = 50061;
+    const int PORT_B = 50062;
+    //和tests/config.ini保持一致
+    const milliseconds TIMEOUT(300);
+    const milliseconds HEDGE_DELAY(50);
+    const int EJECT_FAILURES = 3;
+    const milliseconds EJECT_TIME(200);
+
+    int failures = 0;
+
+    void Check(bool ok, const std::string& what) {
+        if (!ok) {
+            std::cout << "FAIL: " << what << std::endl;
+            ++failures;
+        }
+    }
+
+    struct CallResult {
+        GetVarifyRsp reply;
+        milliseconds elapsed;
+    };
+
+    //发起count次调用，concurrent为false时一个完成后再发下一个；每次调用的HTTP截止时间是发起后httpDeadline
+    std::vector<CallResult> RunCalls(int count, bool concurrent, milliseconds httpDeadline = milliseconds(2000)) {
+        net::io_context ioc;
+        //完成回调从gRPC线程投递回来，等待期间io_context不能因为没有任务而退出
+        auto guard = net::make_work_guard(ioc);
+        std::vector<CallResult> results(count);
+        int remaining = count;
+
+        auto call = [&](int index) -> net::awaitable<void> {
+            auto start = std::chrono::steady_clock::now();
+            auto reply = co_await VerifyGrpcClient::GetInstance()->AsyncGetVarifyCode(
+                "test@example.com", start + httpDeadline);
+            results[index] = { reply, std::chrono::duration_cast<milliseconds>(std::chrono::steady_clock::now() - start) };
+            if (--remaining == 0) {
+                guard.reset();
+            }
+        };
+
+        if (concurrent) {
+            for (int i = 0; i < count; ++i) {
+                net::co_spawn(ioc, call(i), net::detached);
+            }
+        }
+        else {
+            net::co_spawn(ioc, [&]() -> net::awaitable<void> {
+                for (int i = 0; i < count; ++i) {
+                    co_await call(i);
+                }
+            }, net::detached);
+        }
+        ioc.run();
+        return results;
+    }
+
+    //让两个实例都正常应答，直到各自成功处理过请求：被摘除的实例到期后重新加入，失败计数清零
+    void Heal(FakeVarifyServer& a, FakeVarifyServer& b) {
+        a.SetMode(Mode::Ok);
+        b.SetMode(Mode::Ok);
+        a.Reset();
+        b.Reset();
+        auto giveUp = std::chrono::steady_clock::now() + EJECT_TIME * 16;
+        while ((a.Requests() == 0 || b.Requests() == 0) && std::chrono::steady_clock::now() < giveUp) {
+            RunCalls(2, false);
+            std::this_thread::sleep_for(milliseconds(20));
+        }
+    }
+
+    //每个用例前恢复实例状态，并等已取消的请求在服务端退出
+    void Prepare(FakeVarifyServer& a, FakeVarifyServer& b, Mode modeA, Mode modeB,
+                 milliseconds delay = milliseconds(0)) {
+        std::this_thread::sleep_for(milliseconds(50));
+        Heal(a, b);
+        a.SetMode(modeA, delay);
+        b.SetMode(modeB, delay);
+        a.Reset();
+        b.Reset();
+    }
+
+    size_t DistinctRequestIds(FakeVarifyServer& a, FakeVarifyServer& b) {
+        auto ids = a.RequestIds();
+        auto idsB = b.RequestIds();
+        ids.insert(idsB.begin(), idsB.end());
+        return ids.size();
+    }
+
+    //A拒绝连接，请求换到B重试，所有调用都成功，同一次调用的请求共用一个请求id
+    void TestRetry(FakeVarifyServer& a, FakeVarifyServer& b) {
+        const int calls = 6;
+        Prepare(a, b, Mode::Unavailable, Mode::Ok);
+        auto before = VerifyGrpcClient::GetInstance()->GetStats();
+        auto results = RunCalls(calls, false);
+        auto after = VerifyGrpcClient::GetInstance()->GetStats();
+
+        for (auto& result : results) {
+            Check(result.reply.error() == ErrorCodes::Success && result.reply.code() == "123456",
+                "retry: call succeeds through B");
+        }
+        Check(a.Requests() > 0, "retry: some calls tried A first");
+        Check(after.retries - before.retries == static_cast<uint64_t>(a.Requests()), "retry: every A failure retried");
+        Check(DistinctRequestIds(a, b) == static_cast<size_t>(calls), "retry: one request id per call");
+    }
+
+    //A很慢，HedgeDelayMs后向B发对冲请求，调用耗时接近对冲延迟而不是A的延迟
+    void TestHedge(FakeVarifyServer& a, FakeVarifyServer& b) {
+        const int calls = 6;
+        Prepare(a, b, Mode::Slow, Mode::Ok, milliseconds(250));
+        auto before = VerifyGrpcClient::GetInstance()->GetStats();
+        auto results = RunCalls(calls, false);
+        auto after = VerifyGrpcClient::GetInstance()->GetStats();
+
+        for (auto& result : results) {
+            Check(result.reply.error() == ErrorCodes::Success, "hedge: call succeeds");
+            Check(result.elapsed < HEDGE_DELAY + milliseconds(150),
+                "hedge: call took " + std::to_string(result.elapsed.count()) + "ms");
+        }
+        Check(after.hedges > before.hedges, "hedge: hedged requests sent");
+        Check(DistinctRequestIds(a, b) == static_cast<size_t>(calls), "hedge: one request id per call");
+    }
+
+    //两个实例都不应答，调用在TimeoutMs或更早的HTTP截止时间到达时失败
+    void TestDeadline(FakeVarifyServer& a, FakeVarifyServer& b) {
+        Prepare(a, b, Mode::Hang, Mode::Hang);
+        auto results = RunCalls(1, false);
+        Check(results[0].reply.error() == ErrorCodes::RPCFailed, "deadline: call fails");
+        Check(results[0].elapsed >= TIMEOUT - milliseconds(20) && results[0].elapsed < TIMEOUT + milliseconds(200),
+            "deadline: TimeoutMs call took " + std::to_string(results[0].elapsed.count()) + "ms");
+
+        Prepare(a, b, Mode::Hang, Mode::Hang);
+        results = RunCalls(1, false, milliseconds(100));
+        Check(results[0].reply.error() == ErrorCodes::RPCFailed, "deadline: call fails");
+        Check(results[0].elapsed < TIMEOUT - milliseconds(100),
+            "deadline: HTTP deadline call took " + std::to_string(results[0].elapsed.count()) + "ms");
+    }
+
+    //A连续失败EjectFailures次后被摘除，请求全部发给B；摘除到期后A收到一个探测请求，
+    //仍然失败则立即再次摘除，时间加倍；A恢复后摘除到期重新分到请求
+    void TestEjection(FakeVarifyServer& a, FakeVarifyServer& b) {
+        Prepare(a, b, Mode::Unavailable, Mode::Ok);
+        auto before = VerifyGrpcClient::GetInstance()->GetStats();
+        for (int i = 0; i < 20 && VerifyGrpcClient::GetInstance()->GetStats().ejections == before.ejections; ++i) {
+            RunCalls(1, false);
+        }
+        auto ejected = VerifyGrpcClient::GetInstance()->GetStats();
+        Check(ejected.ejections == before.ejections + 1, "ejection: A ejected");
+        Check(a.Requests() == EJECT_FAILURES, "ejection: ejected after EjectFailures failures");
+        Check(ejected.healthy == 1, "ejection: one healthy endpoint");
+
+        a.Reset();
+        auto results = RunCalls(10, false);
+        Check(a.Requests() == 0, "ejection: no requests to ejected A");
+        for (auto& result : results) {
+            Check(result.reply.error() == ErrorCodes::Success, "ejection: calls succeed on B");
+        }
+
+        //摘除到期，探测请求失败后立即再次摘除
+        std::this_thread::sleep_for(EJECT_TIME + milliseconds(50));
+        a.Reset();
+        for (int i = 0; i < 10 && a.Requests() == 0; ++i) {
+            RunCalls(1, false);
+        }
+        Check(a.Requests() == 1, "ejection: one probe after EjectTimeMs");
+        Check(VerifyGrpcClient::GetInstance()->GetStats().ejections == before.ejections + 2,
+            "ejection: failed probe ejects again");
+
+        //第二次摘除时间加倍，过了EjectTimeMs仍然不分请求
+        std::this_thread::sleep_for(EJECT_TIME + milliseconds(50));
+        a.Reset();
+        RunCalls(10, false);
+        Check(a.Requests() == 0, "ejection: second ejection backs off");
+
+        //A恢复，摘除到期后重新分到请求
+        a.SetMode(Mode::Ok);
+        std::this_thread::sleep_for(EJECT_TIME + milliseconds(100));
+        a.Reset();
+        results = RunCalls(10, false);
+        Check(a.Requests() > 0, "ejection: A rejoins after recovering");
+        Check(VerifyGrpcClient::GetInstance()->GetStats().healthy == 2, "ejection: both endpoints healthy");
+        for (auto& result : results) {
+            Check(result.reply.error() == ErrorCodes::Success, "ejection: calls succeed after rejoin");
+        }
+    }
+
+    //两个实例都拒绝，大量调用同时失败时重试数受预算限制
+    void TestBudget(FakeVarifyServer& a, FakeVarifyServer& b) {
+        const int calls = 200;
+        Prepare(a, b, Mode::Unavailable, Mode::Unavailable);
+        auto before = VerifyGrpcClient::GetInstance()->GetStats();
+        auto results = RunCalls(calls, true);
+        auto after = VerifyGrpcClient::GetInstance()->GetStats();
+
+        for (auto& result : results) {
+            Check(result.reply.error() == ErrorCodes::RPCFailed, "budget: call fails");
+        }
+        Check(after.failures - before.failures == static_cast<uint64_t>(calls), "budget: failures counted");
+        Check(after.budgetExhausted > before.budgetExhausted, "budget: retries refused");
+        Check(after.retries - before.retries < static_cast<uint64_t>(calls / 2), "budget: retries bounded");
+        //对冲请求也从预算里扣
+        uint64_t extra = after.retries - before.retries + after.hedges - before.hedges;
+        Check(static_cast<uint64_t>(a.Requests() + b.Requests()) == calls + extra, "budget: only budgeted retries sent");
+    }
+}
+
+int main() {
+    FakeVarifyServer a(PORT_A);
+    FakeVarifyServer b(PORT_B);
+
+    //预热：建立到两个实例的连接，不计入用例
+    RunCalls(4, false);
+
+    TestRetry(a, b);
+    TestHedge(a, b);
+    TestDeadline(a, b);
+    TestEjection(a, b);
+    TestBudget(a, b);
+
+    if (failures) {
+        std::cout << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "VerifyClientTest passed" << std::endl;
+    return 0;
+}
@@ -1,4 +1,7 @@
 let code_prefix = 'code:';
+// 网关一次调用的重试和对冲请求带同一个请求id，按它去重
+let request_prefix = 'varify_req:';
+let request_id_header = 'x-request-id';
 
 const Errors = {
     // 通用错误码
@@ -14,5 +17,7 @@ const Errors = {
 
 module.exports = {
     code_prefix,
+    request_prefix,
+    request_id_header,
     Errors,
 }
\ No newline at end of file
@@ -71,6 +71,52 @@ async function saveVarifyCode(email, code, expireTime = 180) {
     }
 }
 
+/**
+ * 认领一次网关调用：同一请求id第一次到达时记下code并返回first为true，由它发送邮件；
+ * 之后到达的重试和对冲请求返回第一次记下的code，first为false，不再发送邮件。
+ * 用户重新获取验证码时网关使用新的请求id，会生成并发送新的验证码。
+ * @param {string} requestId 网关的请求id
+ * @param {string} code 新生成的验证码
+ * @param {number} expireTime 过期时间（秒）
+ * @returns {Promise<{first: boolean, code: string}|null>} 认领结果，Redis出错返回null
+ */
+async function claimVarifyRequest(requestId, code, expireTime = 180) {
+    try {
+        await initRedis();
+        if (!redisAvailable) {
+            console.warn('Redis不可用，无法对请求去重');
+            return { first: true, code }; // 继续流程，不中断服务
+        }
+        
+        const key = `${const_module.request_prefix}${requestId}`;
+        const stored = await redisClient.set(key, code, 'EX', expireTime, 'NX');
+        if (stored === 'OK') {
+            return { first: true, code };
+        }
+        const existing = await redisClient.get(key);
+        // 刚好在两次操作之间过期，按新请求处理
+        return existing ? { first: false, code: existing } : { first: true, code };
+    } catch (error) {
+        console.error('请求去重失败:', error);
+        return null;
+    }
+}
+
+/**
+ * 放弃认领，邮件发送失败时调用，让同一请求的重试重新发送
+ * @param {string} requestId 网关的请求id
+ */
+async function releaseVarifyRequest(requestId) {
+    try {
+        await initRedis();
+        if (redisAvailable) {
+            await redisClient.del(`${const_module.request_prefix}${requestId}`);
+        }
+    } catch (error) {
+        console.error('释放请求失败:', error);
+    }
+}
+
 /**
  * 获取验证码
  * @param {string} email 邮箱
@@ -126,6 +172,8 @@ async function validateVarifyCode(email, code) {
 module.exports = {
     initRedis,
     saveVarifyCode,
+    claimVarifyRequest,
+    releaseVarifyRequest,
     getVarifyCode,
     validateVarifyCode
 }; 
\ No newline at end of file
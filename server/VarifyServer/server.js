@@ -29,19 +29,47 @@ async function GetVarifyCode(call, callback) {
     console.log("开始处理验证码请求，email是:", call.request.email)
     try{
         // 生成6位数字验证码
-        const varifyCode = Math.floor(100000 + Math.random() * 900000).toString();
+        let varifyCode = Math.floor(100000 + Math.random() * 900000).toString();
         console.log("生成的验证码是: ", varifyCode)
         
-        // 将验证码存入Redis，设置过期时间
+        // 网关的重试和对冲请求可能把同一次调用发到多个实例，它们带同一个请求id，
+        // 只有第一个到达的请求保存验证码并发送邮件，其余的直接返回同一个验证码
+        const requestId = call.metadata.get(const_module.request_id_header)[0];
+        if (requestId) {
+            const claim = await redisModule.claimVarifyRequest(
+                requestId, 
+                varifyCode, 
+                config_module.code_expire
+            );
+            if (!claim) {
+                return callback(null, { 
+                    email: call.request.email,
+                    error: const_module.Errors.REDIS_ERROR
+                });
+            }
+            if (!claim.first) {
+                console.log("重复的请求，不再发送邮件，请求id:", requestId);
+                return callback(null, { 
+                    email: call.request.email,
+                    error: const_module.Errors.SUCCESS,
+                    code: claim.code
+                });
+            }
+        }
+        
+        // 将验证码存入Redis，设置过期时间；重新获取验证码时覆盖旧的
         console.log("开始保存验证码到Redis...");
-        const saveResult = await redisModule.saveVarifyCode(
+        const saved = await redisModule.saveVarifyCode(
             call.request.email, 
             varifyCode, 
             config_module.code_expire
         );
         
-        if (!saveResult) {
+        if (!saved) {
             console.log("存储验证码到Redis失败");
+            if (requestId) {
+                await redisModule.releaseVarifyRequest(requestId);
+            }
             return callback(null, { 
                 email: call.request.email,
                 error: const_module.Errors.REDIS_ERROR
@@ -65,6 +93,9 @@ async function GetVarifyCode(call, callback) {
             console.log("邮件发送成功，结果:", send_res);
         } catch (emailError) {
             console.error("邮件发送失败，详细错误：", emailError);
+            if (requestId) {
+                await redisModule.releaseVarifyRequest(requestId);
+            }
             return callback(null, { 
                 email: call.request.email,
                 error: const_module.Errors.Exception